@@ -41,6 +41,9 @@
 #ifdef USE_SDL
 
 #include <unistd.h>
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
 #define SDL_MAIN_HANDLED        /*To fix SDL's "undefined reference to WinMain" issue*/
 #include <SDL2/SDL.h>
 #include "display/monitor.h"
@@ -48,28 +51,336 @@
 #include "indev/mousewheel.h"
 #include "indev/keyboard.h"
 #include "sdl/sdl.h"
+#include "app_hal.h"
 
 
+// Monotonic milliseconds. hal_tick_get() is relative to clockBase, which is moved when leaving
+// the virtual clock so time carries on from where the virtual clock left it.
+static uint64_t clockBase = 0;
+static volatile bool bVirtualClock = false;
+static volatile uint32_t virtualMs = 0;
+
+static uint64_t monotonic_ms(void) {
+#ifdef WIN32
+    return SDL_GetPerformanceCounter() / (SDL_GetPerformanceFrequency() / 1000);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+uint32_t hal_tick_get(void) {
+    if (bVirtualClock)
+        return virtualMs;
+    if (!clockBase)
+        clockBase = monotonic_ms();     // LVGL may ask before hal_setup()
+    return (uint32_t)(monotonic_ms() - clockBase);
+}
+
+void hal_set_virtual_clock(bool bVirtual) {
+    if (bVirtual == bVirtualClock)
+        return;
+
+    if (bVirtual)
+        virtualMs = hal_tick_get();
+    else
+        clockBase = monotonic_ms() - virtualMs;
+    bVirtualClock = bVirtual;
+}
+
+bool hal_is_virtual_clock(void) {
+    return bVirtualClock;
+}
+
+void hal_advance_clock(uint32_t ms) {
+    if (!bVirtualClock)
+        return;
+
+    virtualMs += ms;
+#if LV_TICK_CUSTOM == 0
+    lv_tick_inc(ms);
+#endif
+}
+
+#if LV_TICK_CUSTOM == 0
 /**
- * A task to measure the elapsed time for LittlevGL
+ * A task to measure the elapsed time for LittlevGL - only needed when lv_conf.h doesn't read
+ * hal_tick_get() through LV_TICK_CUSTOM. The increments come from the monotonic clock so they
+ * don't drift however late the thread is woken.
  * @param data unused
  * @return never return
  */
 static int tick_thread(void * data)
 {
     (void)data;
+    uint64_t last = monotonic_ms();
 
     while(1) {
-        SDL_Delay(5);   /*Sleep for 5 millisecond*/
-        lv_tick_inc(5); /*Tell LittelvGL that 5 milliseconds were elapsed*/
+        SDL_Delay(5);   /*Sleep for about 5 milliseconds*/
+        uint64_t now = monotonic_ms();
+        if (!bVirtualClock)
+            lv_tick_inc((uint32_t)(now - last));   /*Tell LittelvGL how much time actually elapsed*/
+        last = now;
     }
 
     return 0;
 }
+#endif
+
+
+static hal_display_config_t dispConfig = { HAL_BUF_PARTIAL, 10, 1, false, false };
+static lv_disp_draw_buf_t disp_buf;
+static lv_disp_drv_t disp_drv;
+static lv_disp_t* pDisp = NULL;
+static lv_color_t* bufs[2] = { NULL, NULL };
+static lv_indev_drv_t indev_drv;
+
+// hal_loop() sleeping and wakeups.
+static lv_timer_t* pSdlEventTimer = NULL;
+static uint32_t wakeEventType = 0;
+static hal_loop_stats_t loopStats;
+
+// Timing accumulated between reports.
+static uint64_t flushTicks = 0;         // SDL performance counter ticks spent in flush.
+static uint32_t refrMs = 0;             // Render + flush time reported by LVGL's monitor_cb.
+static uint32_t refrCount = 0;
+static uint64_t refrPixels = 0;
+static uint32_t lastReport = 0;
+
+// Asynchronous flush: flushed areas are queued here and the copy thread moves them into the SDL
+// driver's frame buffer, then calls lv_disp_flush_ready(). With two draw buffers LVGL renders the
+// next area meanwhile. The SDL renderer isn't thread safe, so the window itself is only ever
+// updated on the main thread - by the SDL driver's event timer, which hal_loop() readies once the
+// last area of a refresh is copied.
+typedef struct {
+    lv_area_t area;
+    lv_color_t* color_p;
+    bool last;
+} hal_flush_item_t;
+
+static hal_flush_item_t flushRing[HAL_FLUSH_RING];
+static uint32_t ringHead = 0;
+static uint32_t ringCount = 0;
+static SDL_mutex* pRingLock = NULL;
+static SDL_cond* pRingCond = NULL;
+static SDL_cond* pDrainCond = NULL;     // Signalled as ringCount drops - see hal_set_display_config().
+static SDL_Thread* pCopyThread = NULL;
+
+//
+// Hand one area to SDL. color_p is either a strip (partial) or, on the last flush of a refresh,
+// the screen sized buffer. The copy thread passes a private driver copy so SDL's
+// lv_disp_flush_is_last()/lv_disp_flush_ready() calls act on its own state rather than LVGL's.
+//
+static void present_area(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p) {
+    if (dispConfig.mode == HAL_BUF_PARTIAL) {
+        sdl_display_flush(drv, area, color_p);
+    }
+    else {
+        lv_area_t full = { 0, 0, (lv_coord_t)(SDL_HOR_RES - 1), (lv_coord_t)(SDL_VER_RES - 1) };
+        sdl_display_flush(drv, &full, color_p);
+    }
+}
+
+static int copy_thread(void* data) {
+    lv_disp_drv_t* drv = (lv_disp_drv_t*)data;
+    static lv_disp_draw_buf_t shadowBuf;
+    static lv_disp_drv_t shadowDrv;
+
+    while(1) {
+        SDL_LockMutex(pRingLock);
+        while (ringCount == 0)
+            SDL_CondWait(pRingCond, pRingLock);
+        hal_flush_item_t item = flushRing[(ringHead + HAL_FLUSH_RING - ringCount) % HAL_FLUSH_RING];
+        SDL_UnlockMutex(pRingLock);
+
+        uint64_t start = SDL_GetPerformanceCounter();
+        shadowDrv = *drv;
+        shadowBuf.flushing = 1;
+        shadowBuf.flushing_last = 0;    // Never last - so SDL only copies and flags a refresh.
+        shadowDrv.draw_buf = &shadowBuf;
+        present_area(&shadowDrv, &item.area, item.color_p);
+        lv_disp_flush_ready(drv);
+
+        // Only now is the item done with the draw buffer and the driver.
+        SDL_LockMutex(pRingLock);
+        flushTicks += SDL_GetPerformanceCounter() - start;
+        ringCount--;
+        SDL_CondBroadcast(pDrainCond);
+        SDL_UnlockMutex(pRingLock);
+        // Have the main thread present the finished frame now rather than on its next poll.
+        if (item.last)
+            hal_wakeup();
+    }
+
+    return 0;
+}
+
+static void timed_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p) {
+    bool last = lv_disp_flush_is_last(drv);
+
+    if (dispConfig.mode != HAL_BUF_PARTIAL) {
+        if (!last) {
+            // Screen sized buffer - nothing to present until the whole frame is rendered.
+            lv_disp_flush_ready(drv);
+            return;
+        }
+        color_p = (lv_color_t*)drv->draw_buf->buf_act;
+    }
+
+    if (dispConfig.asyncFlush) {
+        // LVGL waits for the previous flush before reusing a buffer, so at most one item per draw
+        // buffer plus the one just made ready is queued - the ring never overruns.
+        SDL_LockMutex(pRingLock);
+        hal_flush_item_t* pItem = &flushRing[ringHead];
+        pItem->area = *area;
+        pItem->color_p = color_p;
+        pItem->last = last;
+        ringHead = (ringHead + 1) % HAL_FLUSH_RING;
+        ringCount++;
+        SDL_CondSignal(pRingCond);
+        SDL_UnlockMutex(pRingLock);
+        return;
+    }
+
+    uint64_t start = SDL_GetPerformanceCounter();
+    present_area(drv, area, color_p);
+    flushTicks += SDL_GetPerformanceCounter() - start;
+}
+
+static uint32_t bufferCount(void) {
+    if (dispConfig.mode == HAL_BUF_PARTIAL)
+        return (dispConfig.asyncFlush || dispConfig.bufCount == 2) ? 2 : 1;
+    return dispConfig.mode == HAL_BUF_DIRECT ? 1 : 2;
+}
+
+static void timing_monitor(lv_disp_drv_t* drv, uint32_t time, uint32_t px) {
+    (void)drv;
+
+    refrMs += time;
+    refrCount++;
+    refrPixels += px;
+
+    if (!dispConfig.printTiming || lv_tick_elaps(lastReport) < HAL_TIMING_PERIOD_MS)
+        return;
+
+    static const char* modeNames[] = { "partial", "direct", "full-refresh" };
+    if (pRingLock)
+        SDL_LockMutex(pRingLock);
+    double flushMs = flushTicks * 1000.0 / SDL_GetPerformanceFrequency();
+    flushTicks = 0;
+    if (pRingLock)
+        SDL_UnlockMutex(pRingLock);
+    // With the async flush the copy overlaps rendering, so refresh time is (mostly) render time.
+    // The window update itself then runs in the SDL event timer and shows up in the loop stats.
+    double renderMs = dispConfig.asyncFlush ? refrMs : (refrMs > flushMs ? refrMs - flushMs : 0);
+
+    printf("hal: %s%s lines=%d buffers=%d: %lu refreshes, render %.2f ms + flush %.2f ms avg, %.1f kpx avg\n",
+           modeNames[dispConfig.mode], dispConfig.asyncFlush ? " async" : "",
+           dispConfig.mode == HAL_BUF_PARTIAL ? dispConfig.bufLines : SDL_VER_RES,
+           (int)bufferCount(), (unsigned long)refrCount, renderMs / refrCount, flushMs / refrCount,
+           refrPixels / 1000.0 / refrCount);
+
+    refrMs = 0;
+    refrCount = 0;
+    refrPixels = 0;
+    lastReport = lv_tick_get();
+}
+
+//
+// (Re)allocate the draw buffers for dispConfig and point the driver at them.
+//
+static void apply_display_config(void) {
+    uint32_t lines = dispConfig.mode == HAL_BUF_PARTIAL ? dispConfig.bufLines : SDL_VER_RES;
+    uint32_t count = bufferCount();
+    uint32_t px = SDL_HOR_RES * lines;
+
+    if (dispConfig.asyncFlush && !pCopyThread) {
+        pRingLock = SDL_CreateMutex();
+        pRingCond = SDL_CreateCond();
+        pDrainCond = SDL_CreateCond();
+        pCopyThread = SDL_CreateThread(copy_thread, "flush copy", &disp_drv);
+    }
+
+    for (uint32_t i=0; i<2; i++) {
+        free(bufs[i]);
+        bufs[i] = (i < count) ? (lv_color_t*)malloc(px * sizeof(lv_color_t)) : NULL;
+    }
+    if (!bufs[0] || (count == 2 && !bufs[1])) {
+        LV_LOG_ERROR("hal: Out of memory for draw buffers.");
+        return;
+    }
+
+    lv_disp_draw_buf_init(&disp_buf, bufs[0], bufs[1], px);
+    disp_drv.draw_buf = &disp_buf;
+    disp_drv.direct_mode = (dispConfig.mode == HAL_BUF_DIRECT);
+    disp_drv.full_refresh = (dispConfig.mode == HAL_BUF_FULL_REFRESH);
+
+    if (pDisp) {
+        lv_disp_drv_update(pDisp, &disp_drv);
+        lv_obj_invalidate(lv_disp_get_scr_act(pDisp));
+    }
+}
+
+void hal_set_display_config(const hal_display_config_t* pConfig) {
+    // Let the copy thread finish with the old buffers and mode first, and keep it out until the
+    // new ones are in place. (apply_display_config() may create the lock - only take an existing one.)
+    SDL_mutex* pLock = pRingLock;
+    if (pLock) {
+        SDL_LockMutex(pLock);
+        while (ringCount)
+            SDL_CondWait(pDrainCond, pLock);
+    }
 
+    dispConfig = *pConfig;
+    if (dispConfig.bufLines < 1)
+        dispConfig.bufLines = 1;
+    if (dispConfig.bufLines > SDL_VER_RES)
+        dispConfig.bufLines = SDL_VER_RES;
+    if (dispConfig.bufCount < 1 || dispConfig.bufCount > 2)
+        dispConfig.bufCount = 1;
+
+    // Before hal_setup() this is just remembered.
+    if (pDisp)
+        apply_display_config();
+
+    if (pLock)
+        SDL_UnlockMutex(pLock);
+}
+
+void hal_get_display_config(hal_display_config_t* pConfig) {
+    *pConfig = dispConfig;
+}
+
+// LVPP_HAL_DISPLAY="lines=40,buffers=2,timing" / "direct" / "full" / "async"
+static void read_display_env(void) {
+    const char* pEnv = getenv("LVPP_HAL_DISPLAY");
+    const char* p;
+
+    if (!pEnv)
+        return;
+
+    hal_display_config_t cfg = dispConfig;
+    if (strstr(pEnv, "direct"))
+        cfg.mode = HAL_BUF_DIRECT;
+    else if (strstr(pEnv, "full"))
+        cfg.mode = HAL_BUF_FULL_REFRESH;
+    if ((p = strstr(pEnv, "lines=")))
+        cfg.bufLines = atoi(p + 6);
+    if ((p = strstr(pEnv, "buffers=")))
+        cfg.bufCount = atoi(p + 8);
+    cfg.printTiming = strstr(pEnv, "timing") != NULL;
+    cfg.asyncFlush = strstr(pEnv, "async") != NULL;
+
+    hal_set_display_config(&cfg);
+}
 
 void hal_setup(void)
 {
+    const char* pClock = getenv("LVPP_HAL_CLOCK");
+    if (pClock && strcmp(pClock, "virtual") == 0)
+        hal_set_virtual_clock(true);
+
     // Workaround for sdl2 `-m32` crash
     // https://bugs.launchpad.net/ubuntu/+source/libsdl2/+bug/1775067/comments/7
     #ifndef WIN32
@@ -79,45 +390,113 @@ void hal_setup(void)
     /* Add a display
      * Use the 'monitor' driver which creates window on PC's monitor to simulate a display*/
 
-    static lv_disp_draw_buf_t disp_buf;
-    static lv_color_t buf[SDL_HOR_RES * 10];                          /*Declare a buffer for 10 lines*/
-    lv_disp_draw_buf_init(&disp_buf, buf, NULL, SDL_HOR_RES * 10);    /*Initialize the display buffer*/
+    read_display_env();
 
-    static lv_disp_drv_t disp_drv;
     lv_disp_drv_init(&disp_drv);              /*Basic initialization*/
-    disp_drv.flush_cb = sdl_display_flush;    /*Used when `LV_VDB_SIZE != 0` in lv_conf.h (buffered drawing)*/
-    disp_drv.draw_buf = &disp_buf;
+    disp_drv.flush_cb = timed_flush;          /*Wraps sdl_display_flush() - see hal_set_display_config()*/
+    disp_drv.monitor_cb = timing_monitor;
     disp_drv.hor_res = SDL_HOR_RES;
     disp_drv.ver_res = SDL_VER_RES;
+    apply_display_config();                   /*Draw buffer(s) per dispConfig*/
     //disp_drv.disp_fill = monitor_fill;      /*Used when `LV_VDB_SIZE == 0` in lv_conf.h (unbuffered drawing)*/
     //disp_drv.disp_map = monitor_map;        /*Used when `LV_VDB_SIZE == 0` in lv_conf.h (unbuffered drawing)*/
-    lv_disp_drv_register(&disp_drv);
+    pDisp = lv_disp_drv_register(&disp_drv);
 
     /* Add the mouse as input device
      * Use the 'mouse' driver which reads the PC's mouse*/
-    static lv_indev_drv_t indev_drv;
     lv_indev_drv_init(&indev_drv);            /*Basic initialization*/
     indev_drv.type = LV_INDEV_TYPE_POINTER;
     indev_drv.read_cb = sdl_mouse_read;       /*This function will be called periodically (by the library) to get the mouse position and state*/
     lv_indev_drv_register(&indev_drv);
 
+    // sdl_init() creates the timer that polls SDL events (at the head of LVGL's timer list).
+    // hal_loop() readies it, and the mouse read timer, as soon as input arrives.
+    lv_timer_t* pBefore = lv_timer_get_next(NULL);
     sdl_init();
+    pSdlEventTimer = lv_timer_get_next(NULL);
+    if (pSdlEventTimer == pBefore)
+        pSdlEventTimer = NULL;
+    wakeEventType = SDL_RegisterEvents(1);
 
     /* Tick init.
-     * You have to call 'lv_tick_inc()' in periodically to inform LittelvGL about how much time were elapsed
-     * Create an SDL thread to do this*/
+     * With LV_TICK_CUSTOM LVGL reads hal_tick_get() itself. Otherwise 'lv_tick_inc()' has to be
+     * called periodically to inform LittelvGL about how much time has elapsed - an SDL thread does this*/
+#if LV_TICK_CUSTOM == 0
     SDL_CreateThread(tick_thread, "tick", NULL);
+#endif
 }
 
 void hal_delay(void) {
-    SDL_Delay(5);
+    if (bVirtualClock)
+        hal_advance_clock(5);
+    else
+        SDL_Delay(5);
 }
 
+void hal_wakeup(void) {
+    if (!wakeEventType || wakeEventType == (uint32_t)-1)
+        return;
+
+    SDL_Event ev;
+    SDL_zero(ev);
+    ev.type = wakeEventType;
+    SDL_PushEvent(&ev);
+}
+
+void hal_get_loop_stats(hal_loop_stats_t* pStats) {
+    *pStats = loopStats;
+}
+
+//
+// Run LVGL timers, then sleep until the next one is due (lv_timer_handler()'s return value)
+// or until an SDL event - input or hal_wakeup() - arrives, whichever is first.
+//
 void hal_loop(void)
 {
+    uint64_t freq = SDL_GetPerformanceFrequency();
+    uint64_t periodStart = SDL_GetPerformanceCounter();
+    uint64_t sleepTicks = 0;
+    uint32_t wakeups = 0;
+    uint32_t maxSleep = 0;
+
     while(1) {
-        SDL_Delay(5);
-        lv_task_handler();
+        uint32_t next = lv_timer_handler();
+        if (next > HAL_LOOP_MAX_SLEEP_MS)
+            next = HAL_LOOP_MAX_SLEEP_MS;
+
+        if (bVirtualClock) {
+            // No sleeping - jump straight to when the next timer is due.
+            hal_advance_clock(next);
+        }
+        else if (next) {
+            uint64_t start = SDL_GetPerformanceCounter();
+            // NULL leaves the event queued for the SDL driver's own event timer.
+            if (SDL_WaitEventTimeout(NULL, next)) {
+                if (pSdlEventTimer)
+                    lv_timer_ready(pSdlEventTimer);
+                if (indev_drv.read_timer)
+                    lv_timer_ready(indev_drv.read_timer);
+            }
+            sleepTicks += SDL_GetPerformanceCounter() - start;
+            wakeups++;
+            if (next > maxSleep)
+                maxSleep = next;
+        }
+
+        uint64_t elapsed = SDL_GetPerformanceCounter() - periodStart;
+        if (elapsed * 1000 >= (uint64_t)HAL_TIMING_PERIOD_MS * freq) {
+            loopStats.idlePercent = 100.0f * sleepTicks / elapsed;
+            loopStats.wakeupsPerSec = (float)wakeups * freq / elapsed;
+            loopStats.maxSleepMs = maxSleep;
+            if (dispConfig.printTiming)
+                printf("hal: loop idle %.1f%%, %.1f wakeups/s, longest sleep %lu ms\n",
+                       loopStats.idlePercent, loopStats.wakeupsPerSec, (unsigned long)maxSleep);
+
+            periodStart += elapsed;
+            sleepTicks = 0;
+            wakeups = 0;
+            maxSleep = 0;
+        }
     }
 }
 
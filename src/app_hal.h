@@ -34,9 +34,14 @@
 #define DRIVER_H
 
 /** @file app_hal.h
- * @brief Support file for app_hal.c which is only used in simulation/native builds.
+ * @brief Support file for app_hal.c (USE_SDL) and app_hal_headless.c (USE_HEADLESS) which are
+ *        only used in simulation/native builds.
 */
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -46,6 +51,155 @@ void hal_setup(void);
 void hal_loop(void);
 void hal_delay(void);
 
+/**
+ * @brief Milliseconds since hal_setup() from a monotonic clock (or the virtual clock when enabled).
+ *        To have LVGL read it directly, with no tick thread, set in lv_conf.h:
+ *            #define LV_TICK_CUSTOM 1
+ *            #define LV_TICK_CUSTOM_INCLUDE "app_hal.h"
+ *            #define LV_TICK_CUSTOM_SYS_TIME_EXPR (hal_tick_get())
+ */
+uint32_t hal_tick_get(void);
+
+#ifdef USE_SDL
+/**
+ * @brief How the SDL HAL gives LVGL its draw buffers.
+ */
+typedef enum {
+    HAL_BUF_PARTIAL=0,      ///< bufLines high buffer(s); LVGL renders dirty areas in strips.
+    HAL_BUF_DIRECT,         ///< One screen sized buffer in LVGL direct mode; only dirty areas are rendered, in place.
+    HAL_BUF_FULL_REFRESH,   ///< Two screen sized buffers; the whole screen is rendered every refresh.
+} hal_buf_mode_t;
+
+/**
+ * @brief Display configuration of the SDL HAL. The default is the historical single 10 line buffer.
+ */
+typedef struct {
+    hal_buf_mode_t mode;
+    uint16_t bufLines;      ///< Buffer height in lines for HAL_BUF_PARTIAL.
+    uint8_t bufCount;       ///< 1 or 2 buffers for HAL_BUF_PARTIAL.
+    bool printTiming;       ///< Print the render/flush split every HAL_TIMING_PERIOD_MS.
+    bool asyncFlush;        ///< Copy flushed areas on a separate thread so rendering overlaps it (the window is still updated on the main thread). Implies 2 buffers for HAL_BUF_PARTIAL.
+} hal_display_config_t;
+
+#ifndef HAL_TIMING_PERIOD_MS
+#define HAL_TIMING_PERIOD_MS 2000   ///< Can be overridden in platform.ini...build_flags with -D HAL_TIMING_PERIOD_MS=n
+#endif
+
+#ifndef HAL_FLUSH_RING
+#define HAL_FLUSH_RING 4            ///< Queue depth of the async flush. Can be overridden with -D HAL_FLUSH_RING=n
+#endif
+
+/**
+ * @brief Change the display configuration. May be called before hal_setup() or at any time after.
+ *        The environment variable LVPP_HAL_DISPLAY, read by hal_setup(), overrides it without
+ *        rebuilding, e.g. LVPP_HAL_DISPLAY="lines=40,buffers=2,timing" or "direct" or "full,async,timing".
+ */
+void hal_set_display_config(const hal_display_config_t* pConfig);
+void hal_get_display_config(hal_display_config_t* pConfig);
+
+#ifndef HAL_LOOP_MAX_SLEEP_MS
+#define HAL_LOOP_MAX_SLEEP_MS 500   ///< Longest hal_loop() sleep when no LVGL timer is due. Can be overridden with -D HAL_LOOP_MAX_SLEEP_MS=n
+#endif
+
+/**
+ * @brief hal_loop() activity over the last HAL_TIMING_PERIOD_MS. Also printed with the display timing.
+ */
+typedef struct {
+    float idlePercent;      ///< Share of wall time spent asleep waiting for the next timer or event.
+    float wakeupsPerSec;
+    uint32_t maxSleepMs;
+} hal_loop_stats_t;
+
+void hal_get_loop_stats(hal_loop_stats_t* pStats);
+
+/**
+ * @brief Wake hal_loop() now, e.g. after another thread queued work for the UI. Safe from any thread.
+ */
+void hal_wakeup(void);
+
+/**
+ * @brief Virtual clock for deterministic and faster than real time runs. While enabled time only
+ *        moves with hal_advance_clock(), and hal_loop() jumps it straight to the next due LVGL timer
+ *        instead of sleeping. Also enabled by the environment variable LVPP_HAL_CLOCK=virtual.
+ */
+void hal_set_virtual_clock(bool bVirtual);
+bool hal_is_virtual_clock(void);
+void hal_advance_clock(uint32_t ms);
+#endif
+
+#ifdef USE_HEADLESS
+// Each can be overridden in platform.ini...build_flags with -D NAME=n
+#ifndef HAL_HEADLESS_HOR_RES
+#define HAL_HEADLESS_HOR_RES 480    ///< Framebuffer width.
+#endif
+#ifndef HAL_HEADLESS_VER_RES
+#define HAL_HEADLESS_VER_RES 320    ///< Framebuffer height.
+#endif
+#ifndef HAL_HEADLESS_BUF_LINES
+#define HAL_HEADLESS_BUF_LINES 10   ///< Lines in the LVGL draw buffer (as app_hal.c).
+#endif
+#ifndef HAL_HEADLESS_FRAME_MS
+#define HAL_HEADLESS_FRAME_MS 5     ///< Synthetic time which passes per frame.
+#endif
+#ifndef HAL_HEADLESS_FRAMES
+#define HAL_HEADLESS_FRAMES 1000    ///< Full screen frames hal_loop() renders as a benchmark after the input script.
+#endif
+
+/**
+ * @brief One step of scripted pointer input. From atMs (synthetic time) on, the pointer is at x,y
+ *        and pressed or not, until the next event.
+ */
+typedef struct {
+    uint32_t atMs;
+    int16_t x;
+    int16_t y;
+    uint8_t pressed;
+} hal_input_event_t;
+
+/**
+ * @brief Totals since hal_setup().
+ */
+typedef struct {
+    uint32_t handlerCalls;      ///< lv_timer_handler() calls made by hal_headless_run_frames().
+    uint32_t framesRendered;    ///< Refreshes which drew something (counted on the last flush of each).
+    uint32_t flushes;           ///< Flushed areas.
+    uint64_t pixelsFlushed;     ///< Pixels rendered and flushed.
+    uint64_t elapsedUs;         ///< Wall time spent in hal_headless_run_frames().
+    uint32_t benchFrames;       ///< Full screen frames rendered by hal_headless_run_benchmark().
+    uint64_t benchPixels;       ///< Pixels flushed by those frames.
+    uint64_t benchUs;           ///< Wall time spent in hal_headless_run_benchmark().
+} hal_headless_stats_t;
+
+/**
+ * @brief Set the pointer input to play back. pEvents must be sorted by atMs and stay valid.
+ */
+void hal_headless_set_script(const hal_input_event_t* pEvents, size_t count);
+/**
+ * @brief Run frames back to back, each advancing synthetic time by HAL_HEADLESS_FRAME_MS and
+ *        calling lv_timer_handler() once. LVGL only renders when its refresh period has passed
+ *        and something is invalid, so most calls draw nothing - see framesRendered.
+ * @return The synthetic time in ms afterwards.
+ */
+uint32_t hal_headless_run_frames(uint32_t frames);
+/**
+ * @brief Render throughput: invalidate the active screen and render it with lv_refr_now(),
+ *        frames times. Timers are not run, so the screen doesn't change between frames.
+ * @return Frames per second of wall time for this run.
+ */
+double hal_headless_run_benchmark(uint32_t frames);
+uint32_t hal_headless_get_time(void);
+bool hal_headless_script_done(void);
+const hal_headless_stats_t* hal_headless_get_stats(void);
+/**
+ * @brief The framebuffer LVGL renders into - HAL_HEADLESS_HOR_RES x HAL_HEADLESS_VER_RES lv_color_t.
+ */
+const void* hal_headless_get_framebuffer(uint32_t* pWidth, uint32_t* pHeight);
+/**
+ * @brief Save the framebuffer as a binary PPM image, e.g. for comparing screenshots in CI.
+ */
+bool hal_headless_write_ppm(const char* pPath);
+#endif
+
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -0,0 +1,231 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+/** @file app_hal_headless.c
+ * @brief Headless HAL for CI and benchmarking. Gated on define of USE_HEADLESS in the build.
+ * 
+ * Provides the same hal_setup()/hal_loop()/hal_delay() as app_hal.c (USE_SDL) but with no window:
+ * LVGL renders into an in-memory framebuffer, time comes from a synthetic tick advanced once per
+ * frame, and pointer input is played back from a script (hal_headless_set_script()). Frames are run
+ * back to back as fast as the CPU allows. hal_loop() then renders the whole screen
+ * HAL_HEADLESS_FRAMES times (hal_headless_run_benchmark()), so the render throughput it prints can
+ * be compared between builds.
+*/
+
+// Like app_hal.c this gets included in all builds and only compiles on USE_HEADLESS defined.
+#ifdef USE_HEADLESS
+
+#ifdef USE_SDL
+#error "USE_HEADLESS and USE_SDL are alternatives. Define only one."
+#endif
+
+#ifdef LV_LVGL_H_INCLUDE_SIMPLE
+#include "lvgl.h"
+#else
+#include "lvgl/lvgl.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "app_hal.h"
+
+static lv_color_t framebuffer[HAL_HEADLESS_HOR_RES * HAL_HEADLESS_VER_RES];
+
+static uint32_t virtualMs = 0;          // The synthetic clock.
+static const hal_input_event_t* pScript = NULL;
+static size_t scriptCount = 0;
+static size_t scriptPos = 0;            // Next script event not yet reached.
+static lv_indev_data_t pointerState;
+
+static hal_headless_stats_t stats;
+
+static uint64_t nowUs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+static void headless_flush(lv_disp_drv_t* disp_drv, const lv_area_t* area, lv_color_t* color_p) {
+    lv_coord_t w = area->x2 - area->x1 + 1;
+
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&framebuffer[y * HAL_HEADLESS_HOR_RES + area->x1], color_p, w * sizeof(lv_color_t));
+        color_p += w;
+    }
+
+    stats.flushes++;
+    stats.pixelsFlushed += (uint64_t)w * (area->y2 - area->y1 + 1);
+    if (lv_disp_flush_is_last(disp_drv))
+        stats.framesRendered++;
+    lv_disp_flush_ready(disp_drv);
+}
+
+static void headless_pointer_read(lv_indev_drv_t* indev_drv, lv_indev_data_t* data) {
+    (void)indev_drv;
+
+    // Apply every script event whose time has come. The last one wins.
+    while (scriptPos < scriptCount && pScript[scriptPos].atMs <= virtualMs) {
+        pointerState.point.x = pScript[scriptPos].x;
+        pointerState.point.y = pScript[scriptPos].y;
+        pointerState.state = pScript[scriptPos].pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+        scriptPos++;
+    }
+
+    data->point = pointerState.point;
+    data->state = pointerState.state;
+}
+
+void hal_setup(void)
+{
+    static lv_disp_draw_buf_t disp_buf;
+    static lv_color_t buf[HAL_HEADLESS_HOR_RES * HAL_HEADLESS_BUF_LINES];
+    lv_disp_draw_buf_init(&disp_buf, buf, NULL, HAL_HEADLESS_HOR_RES * HAL_HEADLESS_BUF_LINES);
+
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.flush_cb = headless_flush;
+    disp_drv.draw_buf = &disp_buf;
+    disp_drv.hor_res = HAL_HEADLESS_HOR_RES;
+    disp_drv.ver_res = HAL_HEADLESS_VER_RES;
+    lv_disp_drv_register(&disp_drv);
+
+    static lv_indev_drv_t indev_drv;
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.type = LV_INDEV_TYPE_POINTER;
+    indev_drv.read_cb = headless_pointer_read;
+    lv_indev_drv_register(&indev_drv);
+
+    memset(&pointerState, 0, sizeof(pointerState));
+    memset(&stats, 0, sizeof(stats));
+}
+
+void hal_delay(void) {
+    // No real time passes headless - a delay is one frame period of synthetic time.
+    virtualMs += HAL_HEADLESS_FRAME_MS;
+#if LV_TICK_CUSTOM == 0
+    lv_tick_inc(HAL_HEADLESS_FRAME_MS);
+#endif
+}
+
+uint32_t hal_tick_get(void) {
+    return virtualMs;
+}
+
+void hal_headless_set_script(const hal_input_event_t* pEvents, size_t count) {
+    pScript = pEvents;
+    scriptCount = pEvents ? count : 0;
+    scriptPos = 0;
+}
+
+uint32_t hal_headless_run_frames(uint32_t frames) {
+    uint64_t start = nowUs();
+
+    for (uint32_t i=0; i<frames; i++) {
+        hal_delay();
+        lv_timer_handler();
+        stats.handlerCalls++;
+    }
+
+    stats.elapsedUs += nowUs() - start;
+    return virtualMs;
+}
+
+double hal_headless_run_benchmark(uint32_t frames) {
+    uint64_t pixels = stats.pixelsFlushed;
+    uint64_t start = nowUs();
+
+    for (uint32_t i=0; i<frames; i++) {
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(NULL);
+    }
+
+    uint64_t spent = nowUs() - start;
+    stats.benchFrames += frames;
+    stats.benchPixels += stats.pixelsFlushed - pixels;
+    stats.benchUs += spent;
+    return spent ? frames * 1e6 / spent : 0.0;
+}
+
+uint32_t hal_headless_get_time(void) {
+    return virtualMs;
+}
+
+bool hal_headless_script_done(void) {
+    return scriptPos >= scriptCount;
+}
+
+const hal_headless_stats_t* hal_headless_get_stats(void) {
+    return &stats;
+}
+
+const void* hal_headless_get_framebuffer(uint32_t* pWidth, uint32_t* pHeight) {
+    if (pWidth)
+        *pWidth = HAL_HEADLESS_HOR_RES;
+    if (pHeight)
+        *pHeight = HAL_HEADLESS_VER_RES;
+    return framebuffer;
+}
+
+bool hal_headless_write_ppm(const char* pPath) {
+    FILE* f = fopen(pPath, "wb");
+    if (!f)
+        return false;
+
+    fprintf(f, "P6\n%d %d\n255\n", HAL_HEADLESS_HOR_RES, HAL_HEADLESS_VER_RES);
+    for (uint32_t i=0; i<HAL_HEADLESS_HOR_RES * HAL_HEADLESS_VER_RES; i++) {
+        uint32_t c = lv_color_to32(framebuffer[i]);
+        uint8_t rgb[3] = { (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c };
+        fwrite(rgb, 1, 3, f);
+    }
+
+    return fclose(f) == 0;
+}
+
+void hal_loop(void)
+{
+    // Play the whole script (if any), let the UI settle for a second of synthetic time, then
+    // measure rendering on its own.
+    while (!hal_headless_script_done())
+        hal_headless_run_frames(1);
+    hal_headless_run_frames(1000 / HAL_HEADLESS_FRAME_MS);
+
+    double secs = stats.elapsedUs / 1e6;
+    printf("headless: script %lu handler calls, %lu frames rendered in %.3f s, %lu ms simulated\n",
+           (unsigned long)stats.handlerCalls, (unsigned long)stats.framesRendered, secs,
+           (unsigned long)virtualMs);
+
+    hal_headless_run_benchmark(HAL_HEADLESS_FRAMES);
+    secs = stats.benchUs / 1e6;
+    printf("headless: benchmark %lu full frames in %.3f s (%.1f frames/s), %.1f Mpixel/s\n",
+           (unsigned long)stats.benchFrames, secs, secs > 0 ? stats.benchFrames / secs : 0.0,
+           secs > 0 ? stats.benchPixels / secs / 1e6 : 0.0);
+}
+
+#endif
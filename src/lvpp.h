@@ -33,25 +33,145 @@
 #include "lvgl/lvgl.h"
 #endif
 
-#ifdef USE_SDL
+#if defined(USE_SDL) || defined(USE_HEADLESS)
 #include "app_hal.h"
 #endif
 
 #include "lvppBase.h"
+#include "lvppArena.h"
+#include "lvppBinding.h"
+#include "lvppTrace.h"
 
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <functional>
 
 /** @file lvpp.h
  * @brief All derived classes for LVGL based class/widgets. This is the file you want to include.
 */
 
+/**
+ * @brief Default time budget, in milliseconds per LVGL timer tick, for building a screen in the
+ *        background with lvppScreen::prefetch(). Build steps are run until this much time has passed.
+ *        Can be overridden in platform.ini...build_flags with -D LVPP_PREFETCH_SLICE_MS=n
+ */
+#ifndef LVPP_PREFETCH_SLICE_MS
+#define LVPP_PREFETCH_SLICE_MS 4
+#endif
+
+/**
+ * @brief Default for lvppKeyboard::setPersistent(). When 1 the shared keyboard is created once and
+ *        hidden/shown rather than created and deleted on every textarea focus change.
+ *        Can be overridden in platform.ini...build_flags with -D LVPP_KEYBOARD_PERSISTENT=1
+ */
+#ifndef LVPP_KEYBOARD_PERSISTENT
+#define LVPP_KEYBOARD_PERSISTENT 0
+#endif
+
+/**
+ * @brief Default idle time (no user input) in milliseconds before lvppKeyboard::precreateWhenIdle()
+ *        creates the keyboard. Can be overridden in platform.ini...build_flags with -D LVPP_KEYBOARD_IDLE_MS=n
+ */
+#ifndef LVPP_KEYBOARD_IDLE_MS
+#define LVPP_KEYBOARD_IDLE_MS 500
+#endif
+
+/** @class lvppKeyboard
+ * @brief On-screen keyboard shared by all lvppTextarea objects. See lvppScreen::getKeyboard().
+ * 
+ * By default the LVGL keyboard is created when a textarea gains focus and deleted when it loses it.
+ * In persistent mode (setPersistent()) it is created once, then only hidden and shown - moving to
+ * whichever screen the focused textarea is on - which removes the creation cost from every focus.
+ */
 class lvppKeyboard : public lvppBase {
 public:
     lvppKeyboard(const char* fName, lv_obj_t* parent=nullptr);
-    void enableKeyboard(bool bEnable=true);
+    ~lvppKeyboard();
+/**
+ * @brief Show or hide the keyboard.
+ * 
+ * @param bEnable true to show the keyboard, false to hide it (or delete it when not persistent).
+ * @param pScreen The screen to show the keyboard on. Defaults to the active screen.
+ */
+    void enableKeyboard(bool bEnable=true, lv_obj_t* pScreen=nullptr);
+/**
+ * @brief Keep the keyboard alive and hidden when not in use rather than deleting it.
+ * 
+ * @param bPersist true for persistent mode. Turning it off deletes a hidden keyboard.
+ */
+    void setPersistent(bool bPersist=true);
+    bool isPersistent() { return bPersistent; };
+/**
+ * @brief Create the keyboard now, hidden, so the first focus does not pay for it. Implies setPersistent().
+ * 
+ * @param pScreen Screen to create it on. Defaults to the active screen.
+ */
+    void precreate(lv_obj_t* pScreen=nullptr);
+/**
+ * @brief Like precreate() but done the first time the user has been idle for idleMs,
+ *        so it does not compete with startup or interaction.
+ * 
+ * @param idleMs Milliseconds without input (lv_disp_get_inactive_time()) before creating.
+ */
+    void precreateWhenIdle(uint32_t idleMs=LVPP_KEYBOARD_IDLE_MS);
+/**
+ * @brief Whether the keyboard is currently shown.
+ */
+    bool isShown() { return obj && !lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN); };
     virtual void eventHandler(lv_event_t* event);
+protected:
+    bool bPersistent=LVPP_KEYBOARD_PERSISTENT;
+    uint32_t precreateIdleMs=0;
+    lv_timer_t* pIdleTimer=nullptr;
+    static void idleTimerCb(lv_timer_t* pTimer);
+    void cancelIdleTimer();
+};
+
+class lvppTextarea;
+
+/**
+ * @brief A pre-resolved reference to an object in an lvppScreen - see lvppScreen::getHandle().
+ * 
+ * Resolving by name once and then updating through the handle skips the name lookup and the
+ * type checks on every update.
+ */
+struct lvppObjHandle {
+    lvppBase* pObj = nullptr;                   ///< The object. nullptr if the name was not found.
+    lvppBaseWithValue* pValueObj = nullptr;     ///< Set when the object supports setValue() (bar, slider, arc).
+    lvppTextarea* pTextareaObj = nullptr;       ///< Set when the object is an lvppTextarea (its setText() differs).
+    lvppScreen* pOwner = nullptr;               ///< Screen which resolved the handle.
+    uint32_t generation = 0;                    ///< pOwner's object generation at the time.
+/**
+ * @brief false once the object is gone - also when a lazy screen has since been unloaded, even
+ *        automatically by the memory budget. Resolve the handle again with getHandle() then.
+ */
+    bool isValid() const;
+};
+
+/**
+ * @brief Per-item result of lvppScreen::applyBatch().
+ */
+enum lvppBatchStatus : uint8_t {
+    LVPP_BATCH_PENDING=0,   ///< Not yet applied.
+    LVPP_BATCH_OK,          ///< Applied.
+    LVPP_BATCH_NOT_FOUND,   ///< No object by that name (or an invalid handle).
+    LVPP_BATCH_WRONG_TYPE,  ///< Object found but doesn't take a value.
+};
+
+/**
+ * @brief One update in a batch given to lvppScreen::applyBatch().
+ * 
+ * Either give a pre-resolved handle (fastest) or a name in pName. When pText is non-null this is
+ * a text update, otherwise value is applied with setValue(). status is filled in by applyBatch().
+ */
+struct lvppBatchItem {
+    lvppObjHandle handle;               ///< Pre-resolved object. Used when valid, otherwise pName is looked up.
+    const char* pName = nullptr;        ///< Object name. Only used when handle is not valid.
+    int16_t value = 0;                  ///< Value for value updates.
+    const char* pText = nullptr;        ///< Text for text updates. nullptr means this is a value update.
+    lvppBatchStatus status = LVPP_BATCH_PENDING;  ///< Result after applyBatch().
 };
 
 /**
@@ -70,6 +190,11 @@ public:
  * and giving a value. The plan is to expand the setObjValue() to encompass several
  * types of objects and also have a getter too.
 */
+/**
+ * @brief Function which creates the widgets of a lazily built lvppScreen. See lvppScreen(lvppScreenBuilder).
+ */
+typedef std::function<void(lvppScreen* pScreen)> lvppScreenBuilder;
+
 /// @todo Add full compliment of object types to setObjValue
 /// @todo Add a getter similar to setObj* as getObj*()
 class lvppScreen { 
@@ -82,7 +207,127 @@ public:
  * @param _pInitScreen The user can pass in an already allocated screen from lvgl if desired.
  */
     lvppScreen(lv_obj_t* _pInitScreen=nullptr);
-    ~lvppScreen() { if (pScreen) lv_obj_del(pScreen); };
+/**
+ * @brief Construct a lazily built screen. Nothing is allocated in LVGL until the screen is
+ *        first activated (or build() is called), at which point _builder is called to populate it.
+ * 
+ * Larger screens can split their construction with addBuildStep() so that prefetch() can build
+ * them in the background a step at a time.
+ * 
+ * The builder should create its widgets with createObject() so that they are freed when the
+ * screen is unloaded. Lazy screens may be unloaded again - explicitly with unload() or by the
+ * memory budget (see setMemoryBudget()) - and are rebuilt by calling the builder on their next
+ * activation. The values of bar, slider and arc widgets are carried across an unload/rebuild,
+ * matched by the order the builder creates them in.
+ * Unloading unbinds the widgets from any lvppObservable (the builder binds the new ones) and
+ * invalidates lvppObjHandle's taken from the screen - check isValid() and call getHandle() again.
+ * 
+ * @param _builder Function which creates the screen's widgets, e.g.
+ *          `lvppScreen settings([](lvppScreen* s) { s->createObject<lvppSlider>("Vol", "Volume"); });`
+ */
+    explicit lvppScreen(lvppScreenBuilder _builder);
+    ~lvppScreen();
+/**
+ * @brief Add a further build step to a lazy screen. Steps are run in order after the builder
+ *        given to the constructor. Each step is the unit of work prefetch() runs at a time.
+ * 
+ * @param step Function which creates some of the screen's widgets.
+ */
+    void addBuildStep(lvppScreenBuilder step);
+/**
+ * @brief Create the LVGL screen and, for lazy screens, run the build steps which have not run
+ *        yet (all of them, or the remainder of a prefetch()). Does nothing if the screen is
+ *        already built. Called by activateScreen() as needed.
+ * 
+ * @return true if the screen was built by this call.
+ */
+    bool build();
+/**
+ * @brief Build a lazy screen in the background so that a later activateScreen() (animated or not)
+ *        does not stall. An LVGL timer runs build steps in time slices of at most maxMsPerTick
+ *        (at least one step per tick), so the current screen stays interactive in between.
+ * 
+ * @param maxMsPerTick Time budget per timer tick in milliseconds.
+ * @return true if a prefetch was started. false if already built or already prefetching.
+ */
+    bool prefetch(uint32_t maxMsPerTick=LVPP_PREFETCH_SLICE_MS);
+/**
+ * @brief Whether a prefetch() is in progress.
+ */
+    bool isPrefetching() { return pPrefetchTimer != nullptr; };
+/**
+ * @brief Milliseconds spent running build steps for the last (or current) build.
+ */
+    uint32_t getBuildTime() { return buildTime; };
+/**
+ * @brief Milliseconds from the start to the end of the last build - for a prefetch() this
+ *        includes the time the UI was running between slices.
+ */
+    uint32_t getBuildElapsed() { return buildElapsed; };
+/**
+ * @brief Number of slices the last build took. 1 for a build done in one go.
+ */
+    uint16_t getBuildSlices() { return buildSlices; };
+/**
+ * @brief Longest single slice of the last build in milliseconds - the worst stall the UI saw.
+ */
+    uint32_t getLongestBuildSlice() { return longestBuildSlice; };
+/**
+ * @brief Number of times this screen has been built.
+ */
+    uint16_t getBuildCount() { return buildCount; };
+/**
+ * @brief Changes every time the screen's objects are destroyed - lvppObjHandle uses it to notice.
+ */
+    uint32_t getObjGeneration() { return objGeneration; };
+/**
+ * @brief Delete the LVGL screen and all of its widgets, keeping what is needed to rebuild it later.
+ *        Only lazy screens which are not currently active - nor being animated in or out by
+ *        lv_scr_load_anim() - can be unloaded.
+ * 
+ * @return true if the screen was unloaded.
+ */
+    bool unload();
+/**
+ * @brief Whether the LVGL side of the screen currently exists.
+ */
+    bool isBuilt() { return pScreen != nullptr && nextBuildStep >= buildSteps.size(); };
+/**
+ * @brief Whether the screen was constructed with a builder (and so can be unloaded).
+ */
+    bool isLazy() { return !buildSteps.empty(); };
+/**
+ * @brief Approximate memory taken by this screen when it was last built - LVGL heap growth during
+ *        the build (when LVGL's own heap is in use) plus the arena reserved for the widgets.
+ * 
+ * @return size_t bytes. 0 when not built.
+ */
+    size_t getBuildCost() { return buildCost; };
+/**
+ * @brief Set the memory budget for lazy screens. When the built lazy screens together cost more
+ *        than this (see getBuildCost()), the least recently used inactive ones are unloaded as
+ *        screens are activated.
+ * 
+ * @param bytes Budget in bytes. 0 (default) is unlimited.
+ */
+    static void setMemoryBudget(size_t bytes) { memoryBudget = bytes; };
+    static size_t getMemoryBudget() { return memoryBudget; };
+/**
+ * @brief Total getBuildCost() of all built lazy screens.
+ */
+    static size_t getLoadedCost();
+/**
+ * @brief Unload least recently used lazy screens until the memory budget is met. The active
+ *        screen, a screen being animated in or out, and pKeep are never unloaded. Called by
+ *        activateScreen().
+ * 
+ * E.g. with a 20k budget and two 15k screens A and B, A->activateScreen(300, LV_SCR_LOAD_ANIM_FADE_ON)
+ * from B keeps both during the fade (over budget for that time). B becomes a candidate on a later
+ * pass, once the animation has finished.
+ * 
+ * @param pKeep Optional screen to leave alone, e.g. the one being transitioned away from.
+ */
+    static void enforceMemoryBudget(lvppScreen* pKeep=nullptr);
 /**
  * @brief Add any lvppBase object pointer to the screen to keep track of.
  *
@@ -97,10 +342,46 @@ public:
  *
  */
     void addObject(lvppBase* pObj);
+/**
+ * @brief Create a widget inside this screen's arena and add it to the screen in one step.
+ * 
+ * Rather than `new lvppButton(...)` followed by addObject(), use
+ *          `lvppButton* pB = myScreen.createObject<lvppButton>("OK", "Okay");`
+ * The wrapper's memory comes from a per-screen lvppArena instead of the general heap and is
+ * released all at once by destroyObjects() or when the screen itself is destroyed. Do not
+ * `delete` objects created this way.
+ * 
+ * @param args The arguments for the widget's constructor.
+ * @return T* The new widget, or nullptr if memory could not be obtained.
+ */
+    template<typename T, typename... Args>
+    T* createObject(Args&&... args) {
+        T* pObj = arena.create<T>(std::forward<Args>(args)...);
+        if (pObj)
+            addObject(pObj);
+        return pObj;
+    };
+/**
+ * @brief Tear down all widgets of the screen in one shot.
+ * 
+ * All LVGL children of the screen are deleted, objects made with createObject() are destroyed
+ * and their arena memory is returned to the heap. Objects which were created by the user and
+ * given to addObject() are no longer tracked by the screen; their LVGL objects are gone but the
+ * C++ objects themselves remain the user's to delete. The screen itself remains usable.
+ * 
+ */
+    void destroyObjects();
+/**
+ * @brief Access the arena used by createObject(), primarily for its statistics
+ *        (getHighWaterMark(), getBytesReserved(), ...).
+ * 
+ * @return lvppArena& reference to this screen's arena.
+ */
+    lvppArena& getArena() { return arena; };
 /**
  * @brief Get a pointer to the LVGL lv_obj_t screen object.
  * 
- * @return lv_obj_t* pointer to an LVGL base object.
+ * @return lv_obj_t* pointer to an LVGL base object. nullptr for a lazy screen which is not built.
  */
     lv_obj_t* getScreen() { return pScreen; };
     //
@@ -149,24 +430,137 @@ public:
  *         in the list of objects added to lvppScreen.
  */
     lvppBase* findObj(const char* pName);
+/**
+ * @brief Look up an object by name once and get back a handle for fast repeated updates
+ *        via setObjValue(const lvppObjHandle&, int16_t).
+ * 
+ * Handles stay valid until the object is destroyed (including by destroyObjects()).
+ * 
+ * @param pName Name of the object.
+ * @return lvppObjHandle The handle. Check isValid() - it is invalid if the name was not found.
+ */
+    lvppObjHandle getHandle(const char* pName);
 /**
  * @brief Set the value of the object objName to val if found.
  * 
  * @param objName Name of the object we're looking for in the list of objects in the lvppScreen.
  * @param val Value to utilize in 'setting' the value once the object is found.
- * @return If the object is found, returns true. Else false.
+ * @return If the object is found and takes a value, returns true. Else false.
  */
     bool setObjValue(const char* objName, int16_t val);
 /**
- * @todo Function incomplete and needs implementation.
+ * @brief Set the value of a pre-resolved object. No lookup takes place.
  * 
+ * @param h Handle obtained from getHandle().
+ * @param val Value to set.
+ * @return true if the handle refers to an object which takes a value.
  */
-    void setObjText(std::string str);
+    bool setObjValue(const lvppObjHandle& h, int16_t val);
+/**
+ * @brief Add an object to the name index. Used by addObject() and lvppBase::setFriendlyName().
+ * 
+ * @param pObj The object (already in this screen).
+ */
+    void indexObject(lvppBase* pObj);
+/**
+ * @brief Remove an object from the name index under its current name.
+ * 
+ * @param pObj The object.
+ */
+    void unindexObject(lvppBase* pObj);
+/**
+ * @brief Set the text of the object objName to pText if found.
+ * 
+ * lvppLabel and lvppTextarea set their text. Other objects set their internal label via
+ * lvppBase::setText().
+ * 
+ * @param objName Name of the object we're looking for in the list of objects in the lvppScreen.
+ * @param pText The new text.
+ * @return true if the object was found.
+ */
+    bool setObjText(const char* objName, const char* pText);
+/**
+ * @brief Set the text of a pre-resolved object. No lookup takes place.
+ * 
+ * @param h Handle obtained from getHandle().
+ * @param pText The new text.
+ * @return true if the handle is valid.
+ */
+    bool setObjText(const lvppObjHandle& h, const char* pText);
+/**
+ * @brief Apply many value and text updates in one go.
+ * 
+ * All items are applied under a single lock (see setLockCallbacks()), so the UI thread never
+ * renders a half applied batch. Per-item invalidation is suppressed: each widget the batch
+ * touches is invalidated once before (its old area) and once after, and gets a single
+ * LV_EVENT_VALUE_CHANGED at the end however many value items addressed it - so value labels,
+ * bindings and listeners see the final value only. Each item's status is filled in. A lazy
+ * screen which is not built (or was unloaded) has no widgets: every item is
+ * LVPP_BATCH_NOT_FOUND and 0 is returned.
+ * 
+ * @param pItems Array of updates.
+ * @param count Number of items in pItems.
+ * @return uint16_t Number of items applied successfully.
+ */
+    uint16_t applyBatch(lvppBatchItem* pItems, size_t count);
+/**
+ * @brief Apply a vector of updates. See applyBatch(lvppBatchItem*, size_t).
+ */
+    uint16_t applyBatch(std::vector<lvppBatchItem>& items) { return applyBatch(items.data(), items.size()); };
+/**
+ * @brief Register functions which lock/unlock LVGL for applyBatch().
+ * 
+ * When LVGL is driven from another thread/task, pass functions taking and giving the mutex that
+ * guards lv_timer_handler(). Either may be nullptr (the default) for no locking.
+ * 
+ * @param _lockFn Called before a batch is applied.
+ * @param _unlockFn Called after a batch is applied.
+ */
+    static void setLockCallbacks(void (*_lockFn)(), void (*_unlockFn)()) { lockFn=_lockFn; unlockFn=_unlockFn; };
+/**
+ * @brief The keyboard shared by the textareas of all screens, e.g. to call
+ *        lvppKeyboard::setPersistent() or lvppKeyboard::precreateWhenIdle().
+ * 
+ * @return lvppKeyboard* The keyboard. nullptr until the first lvppScreen is constructed.
+ */
+    static lvppKeyboard* getKeyboard() { return pKB; };
 protected:
     static lvppKeyboard* pKB;       ///< Keyboard object for the screen.
     lv_obj_t* pScreen=nullptr; ///< The actual underlying LVGL screen pointer.
     lv_obj_t* pPriorScreen;     ///< Holder for prior screen when activateScreen() is called. Used in activatePriorScreen()
     std::vector<lvppBase*> objects; ///< Data structure used to hold all of the object pointers.
+    std::unordered_multimap<uint32_t, lvppBase*> nameIndex;    ///< Hash of friendly name -> object for findObj().
+    static uint32_t hashName(const char* pName);
+    static void (*lockFn)();        ///< See setLockCallbacks().
+    static void (*unlockFn)();
+    lvppArena arena;                ///< Storage for objects made via createObject().
+    std::vector<lvppScreenBuilder> buildSteps;  ///< Set for lazy screens. The constructor's builder is first.
+    size_t nextBuildStep=0;         ///< Index of the next step to run. All run when == buildSteps.size().
+    size_t buildCost=0;             ///< See getBuildCost().
+    size_t heapAtBuildStart=0;
+    uint32_t buildStartTick=0;
+    uint32_t buildTime=0;           ///< See getBuildTime().
+    uint32_t buildElapsed=0;        ///< See getBuildElapsed().
+    uint32_t longestBuildSlice=0;   ///< See getLongestBuildSlice().
+    uint16_t buildSlices=0;         ///< See getBuildSlices().
+    uint16_t buildCount=0;          ///< See getBuildCount().
+    uint32_t objGeneration=0;       ///< See getObjGeneration().
+    uint32_t prefetchSliceMs=0;
+    lv_timer_t* pPrefetchTimer=nullptr;
+    uint32_t lastUsed=0;            ///< Activation stamp for the LRU unload.
+    bool bScrollBarsDisabled=false; ///< Re-applied when a lazy screen is rebuilt.
+    lvppScreen* pPriorLvppScreen=nullptr;   ///< The lvppScreen (if any) of pPriorScreen. Survives its unload.
+    std::vector<std::pair<uint32_t, int16_t>> savedValues;  ///< Widget values kept over an unload, by creation index.
+    static std::vector<lvppScreen*> screens;   ///< All lvppScreens in existence.
+    static uint32_t useCounter;
+    static size_t memoryBudget;
+    static lvppScreen* findScreen(lv_obj_t* pScr);
+    static void prefetchTimerCb(lv_timer_t* pTimer);
+    void beginBuild();
+    bool runBuildSteps(uint32_t maxMs);
+    void finishBuild();
+    void cancelPrefetch();
+    void markUsed() { lastUsed = ++useCounter; };
 };
 
 /** @class lvppSwitch
@@ -281,7 +675,14 @@ protected:
  * 
  * @param pOpts newline-separated list of options. Unused for lvppCycleButton.
  */
-    void lvOptionSetter(const char* pOpts) { setText(options[currentIndex].c_str()); };
+    void lvOptionSetter(const char* pOpts) { if (currentIndex < options.size()) setText(options[currentIndex].c_str()); };
+/**
+ * @brief Appending an option only changes the label when it is the first one.
+ * 
+ * @param pOpt The option which was added.
+ * @return Always true - the newline separated list is never needed.
+ */
+    virtual bool lvOptionAppender(const char* pOpt) { if (options.size()==1) setText(pOpt); return true; };
 /**
  * @brief This is the implementation of the pure virtual in lvppOptions. It is responsible
  *        for doing the actual class-specific 'get' - in this case just the currentIndex.
@@ -656,7 +1057,7 @@ public:
  * 
  * @return uint16_t Value from 0-(n-1) of the selected option.
  */
-    uint16_t getSelectedIndex() { return (uint16_t)lv_dropdown_get_selected(obj); };
+    uint16_t getSelectedIndex() { return (uint16_t)getSelectedOptionIndex(); };
 /**
  * @brief Set the selected option manually/programmatically.
  * 
@@ -679,6 +1080,13 @@ protected:
  * @param pOpts newline-separated list of options.
  */
     void lvOptionSetter(const char* pOpts);
+/**
+ * @brief Appends with lv_dropdown_add_option() so adding one option doesn't re-set the whole list.
+ * 
+ * @param pOpt The option which was added.
+ * @return false if the widget's list is out of step with options and needs a full set.
+ */
+    virtual bool lvOptionAppender(const char* pOpt);
 /**
  * @brief This is the implementation of the pure virtual in lvppOptions. It is responsible
  *        for doing the actual class-specific 'get' - in this case lv_dropdown_get_selected().
@@ -692,6 +1100,10 @@ protected:
  * @param _val is the index to use when setting the object 'value'
  */
     virtual void lvOptionSetIndex(uint16_t _val);
+/**
+ * @brief Lets virtual mode move its window when the user changes the selection.
+ */
+    virtual void internalOnValueChanged() { onWidgetIndexChanged(); };
 };
 
 /**
@@ -730,7 +1142,7 @@ public:
  * 
  * @return uint16_t Value from 0-(n-1) of the selected option.
  */
-    uint16_t getSelectedIndex() { return lv_roller_get_selected(obj); };
+    uint16_t getSelectedIndex() { return (uint16_t)getSelectedOptionIndex(); };
 /**
  * @brief Set the selected option manually/programmatically.
  * 
@@ -766,6 +1178,10 @@ protected:
  * @param _val is the index to use when setting the object 'value'
  */
     virtual void lvOptionSetIndex(uint16_t _val);
+/**
+ * @brief Lets virtual mode move its window when the user changes the selection.
+ */
+    virtual void internalOnValueChanged() { onWidgetIndexChanged(); };
     // TODO: Add a vector of pair<int,string> and a map<int,int> indexToID and map<int,int> IDToIndex
     //       Then we can have a simple 'addOptions' where the user only can get the index or value out.
     //       But they can also addOptions(vector<pair<int,string>>) which then utilizes the map entries too.
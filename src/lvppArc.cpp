@@ -52,8 +52,8 @@ void lvppArc::baseSetter(int16_t nVal, bool animate) {
 }
 
 void lvppArc::setArcColor(lv_color_t newColor) {
-    lv_style_set_arc_color(&style_obj, newColor);
-    lv_obj_invalidate(obj);
+    styleProps.setArcColor(newColor);
+    applySharedStyle();
 }
 
 void lvppArc::setArcRotationAndSweep(uint16_t rot, uint16_t startAngle, uint16_t endAngle) {
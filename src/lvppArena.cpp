@@ -0,0 +1,103 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#include "lvppArena.h"
+
+#include <stdlib.h>
+
+/** @file lvppArena.cpp
+ * @brief Implementation of lvppArena.
+ */
+
+size_t lvppArena::globalBytesReserved = 0;
+size_t lvppArena::globalHighWaterMark = 0;
+
+/**
+ * @brief Round v up to a multiple of align (which is a power of two).
+ */
+static inline uintptr_t alignUp(uintptr_t v, size_t align) {
+    return (v + align - 1) & ~(uintptr_t)(align - 1);
+}
+
+void* lvppArena::allocate(size_t size, size_t align, objHeader*& pHdr) {
+    if (align < alignof(objHeader))
+        align = alignof(objHeader);
+
+    // Try the current block first.
+    if (pBlocks) {
+        uintptr_t base = (uintptr_t)(pBlocks + 1);
+        uintptr_t hdr = alignUp(base + pBlocks->used, alignof(objHeader));
+        uintptr_t obj = alignUp(hdr + sizeof(objHeader), align);
+        if (obj + size <= base + pBlocks->size) {
+            size_t newUsed = obj + size - base;
+            bytesUsed += newUsed - pBlocks->used;
+            pBlocks->used = newUsed;
+            if (bytesUsed > highWaterMark)
+                highWaterMark = bytesUsed;
+            pHdr = (objHeader*)hdr;
+            return (void*)obj;
+        }
+    }
+
+    // Start a new block. Oversized objects get a block sized just for them.
+    size_t need = sizeof(objHeader) + align + size;
+    size_t bSize = need > blockSize ? need : blockSize;
+    block* pB = (block*)malloc(sizeof(block) + bSize);
+    if (!pB)
+        return nullptr;
+
+    pB->pNext = pBlocks;
+    pB->size = bSize;
+    pB->used = 0;
+    pBlocks = pB;
+    blockCount++;
+    bytesReserved += bSize;
+    globalBytesReserved += bSize;
+    if (globalBytesReserved > globalHighWaterMark)
+        globalHighWaterMark = globalBytesReserved;
+
+    return allocate(size, align, pHdr);
+}
+
+void lvppArena::reset() {
+    // Destroy newest first so later objects can still refer to earlier ones while going away.
+    while (pLastObj) {
+        objHeader* pHdr = pLastObj;
+        pLastObj = pHdr->pPrev;
+        pHdr->dtor(pHdr->pObj);
+    }
+
+    while (pBlocks) {
+        block* pB = pBlocks;
+        pBlocks = pB->pNext;
+        globalBytesReserved -= pB->size;
+        free(pB);
+    }
+
+    bytesUsed = bytesReserved = 0;
+    blockCount = objectCount = 0;
+}
@@ -0,0 +1,141 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#ifndef _LVPPARENA_H
+#define _LVPPARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <new>
+#include <utility>
+
+/** @file lvppArena.h
+ * @brief Arena allocation for lvpp wrapper objects - typically one arena per lvppScreen.
+ */
+
+/**
+ * @brief Default size of each block an lvppArena takes from the heap.
+ *        Can be overridden in platform.ini...build_flags with -D LVPP_ARENA_BLOCK_SIZE=n
+ */
+#ifndef LVPP_ARENA_BLOCK_SIZE
+#define LVPP_ARENA_BLOCK_SIZE 4096
+#endif
+
+/**
+ * @brief A bump allocator which constructs objects into a few large heap blocks and destroys
+ *        them all in one shot.
+ * 
+ * Building and tearing down screens of hundreds of widgets with `new`/`delete` leaves the
+ * heap fragmented (watch the LARGEST column in espSystats). An arena takes memory from the
+ * heap in LVPP_ARENA_BLOCK_SIZE blocks, hands out pieces of those blocks to create<T>() and
+ * returns the whole blocks when reset() is called.
+ * 
+ * Each object remembers its own destructor, so the objects do not need a virtual destructor
+ * and are destroyed as their real type, in reverse order of creation.
+ */
+class lvppArena {
+public:
+/**
+ * @brief Construct a new arena. No memory is taken until the first create().
+ * 
+ * @param _blockSize Size of each heap block. Objects larger than this get a block of their own.
+ */
+    lvppArena(size_t _blockSize=LVPP_ARENA_BLOCK_SIZE) : blockSize(_blockSize) { };
+    ~lvppArena() { reset(); };
+    lvppArena(const lvppArena&) = delete;
+    lvppArena& operator=(const lvppArena&) = delete;
+/**
+ * @brief Construct a T inside the arena.
+ * 
+ * @param args Arguments given to T's constructor.
+ * @return T* the new object or nullptr if the heap could not supply a new block.
+ */
+    template<typename T, typename... Args>
+    T* create(Args&&... args) {
+        objHeader* pHdr;
+        void* p = allocate(sizeof(T), alignof(T), pHdr);
+        if (!p)
+            return nullptr;
+
+        T* pObj = new (p) T(std::forward<Args>(args)...);
+
+        // Only link the object in once it is fully constructed.
+        pHdr->pObj = pObj;
+        pHdr->dtor = [](void* o) { static_cast<T*>(o)->~T(); };
+        pHdr->pPrev = pLastObj;
+        pLastObj = pHdr;
+        objectCount++;
+        return pObj;
+    };
+/**
+ * @brief Destroy every object in the arena (newest first) and return all blocks to the heap.
+ * 
+ */
+    void reset();
+    size_t getBytesUsed() { return bytesUsed; };                ///< Bytes handed out (objects + bookkeeping).
+    size_t getBytesReserved() { return bytesReserved; };        ///< Bytes currently held from the heap.
+    size_t getHighWaterMark() { return highWaterMark; };        ///< Peak getBytesUsed() over the arena's lifetime.
+    uint32_t getBlockCount() { return blockCount; };
+    uint32_t getObjectCount() { return objectCount; };
+/**
+ * @brief Peak of the total bytes reserved from the heap by all arenas combined.
+ */
+    static size_t getGlobalHighWaterMark() { return globalHighWaterMark; };
+/**
+ * @brief Total bytes currently reserved from the heap by all arenas combined.
+ */
+    static size_t getGlobalBytesReserved() { return globalBytesReserved; };
+protected:
+    struct block {
+        block* pNext;
+        size_t size;        ///< Usable bytes following this header.
+        size_t used;
+    };
+    struct objHeader {
+        objHeader* pPrev;
+        void (*dtor)(void*);
+        void* pObj;
+    };
+/**
+ * @brief Carve out room for an objHeader followed by an object of the given size and alignment.
+ * 
+ * @return void* where the object must be constructed, or nullptr if out of memory.
+ */
+    void* allocate(size_t size, size_t align, objHeader*& pHdr);
+    size_t blockSize;
+    block* pBlocks = nullptr;           ///< Most recent block first. Allocation happens from the head.
+    objHeader* pLastObj = nullptr;
+    size_t bytesUsed = 0;
+    size_t bytesReserved = 0;
+    size_t highWaterMark = 0;
+    uint32_t blockCount = 0;
+    uint32_t objectCount = 0;
+    static size_t globalBytesReserved;
+    static size_t globalHighWaterMark;
+};
+
+#endif
@@ -25,9 +25,10 @@
 // OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //
-#include "lvppBase.h"
+#include "lvpp.h"
 
 #include <algorithm>
+#include <string.h>
 
 /** @file lvppBase.cpp
  * @brief Implementation of the base class for the library - lvppBase.
@@ -43,6 +44,7 @@
 //#define LOG_EVENTS
 
 bool lvppBase::bEventNamesInitComplete = false;
+uint32_t lvppBase::skippedLabelUpdates = 0;
 
 /**************************
  * 
@@ -59,31 +61,31 @@ void lvppBase::setFontSize(uint8_t points) {
 
     switch(points) {
         case 8:
-            lv_style_set_text_font(&style_obj, &lv_font_montserrat_8);
+            styleProps.setTextFont(&lv_font_montserrat_8);
             break;
         case 10:
-            lv_style_set_text_font(&style_obj, &lv_font_montserrat_10);
+            styleProps.setTextFont(&lv_font_montserrat_10);
             break;
         case 12:
-            lv_style_set_text_font(&style_obj, &lv_font_montserrat_12);
+            styleProps.setTextFont(&lv_font_montserrat_12);
             break;
         case 14:
-            lv_style_set_text_font(&style_obj, &lv_font_montserrat_14);
+            styleProps.setTextFont(&lv_font_montserrat_14);
             break;
         case 16:
-            lv_style_set_text_font(&style_obj, &lv_font_montserrat_16);
+            styleProps.setTextFont(&lv_font_montserrat_16);
             break;
         case 18:
-            lv_style_set_text_font(&style_obj, &lv_font_montserrat_18);
+            styleProps.setTextFont(&lv_font_montserrat_18);
             break;
         case 20:
-            lv_style_set_text_font(&style_obj, &lv_font_montserrat_20);
+            styleProps.setTextFont(&lv_font_montserrat_20);
             break;
         case 22:
-            lv_style_set_text_font(&style_obj, &lv_font_montserrat_22);
+            styleProps.setTextFont(&lv_font_montserrat_22);
             break;
         case 24:
-            lv_style_set_text_font(&style_obj, &lv_font_montserrat_24);
+            styleProps.setTextFont(&lv_font_montserrat_24);
             break;
         default:
             LV_LOG_ERROR("lvppBase::setFontSize() - font size not available. Error.\n");
@@ -91,12 +93,32 @@ void lvppBase::setFontSize(uint8_t points) {
             return;
     }
 
-    lv_obj_add_style(obj, &style_obj, LV_PART_MAIN | LV_STATE_DEFAULT);
+    applySharedStyle();
 }
 
 void lvppBase::setFont(const lv_font_t* pF) {
-    lv_style_set_text_font(&style_obj, pF);
-    lv_obj_add_style(obj, &style_obj, LV_PART_MAIN | LV_STATE_DEFAULT);
+    styleProps.setTextFont(pF);
+    applySharedStyle();
+}
+
+void lvppBase::applySharedStyle() {
+    lvppSharedStyle* pOld = pSharedStyle;
+
+    pSharedStyle = styleProps.isEmpty() ? nullptr : lvppStyleRegistry::acquire(styleProps);
+    if (pSharedStyle == pOld) {
+        // Same interned style as before - only drop the extra reference acquire() just took.
+        lvppStyleRegistry::release(pOld);
+        return;
+    }
+
+    if (obj) {
+        if (pOld)
+            lv_obj_remove_style(obj, &pOld->style, LV_PART_MAIN | LV_STATE_DEFAULT);
+        if (pSharedStyle)
+            lv_obj_add_style(obj, &pSharedStyle->style, LV_PART_MAIN | LV_STATE_DEFAULT);
+    }
+
+    lvppStyleRegistry::release(pOld);
 }
 
 /** @todo I think this add_style needs to go away and an 'invalidate' should be used instead.
@@ -116,7 +138,7 @@ void lvppBase::setBGColor(lv_color_t color) {
 
 void lvppBase::setColorGradient(lv_color_t col1, lv_color_t col2, lv_grad_dir_t direction) {
     lv_style_selector_t sel;
-    std::string ot = getObjType();
+    const std::string& ot = getObjType();
 
     if (ot=="BAR" || ot=="SLIDER" || ot=="ARC") {
         sel = LV_PART_INDICATOR;
@@ -133,8 +155,7 @@ lvppBase::lvppBase(const char* fName, const char* oType) {
   if (!bEventNamesInitComplete)
     initEventNames();
 
-  cbOnClicked = nullptr;
-  cbOnValueChanged = nullptr;
+  pSignals = nullptr;
   obj = nullptr;
   objParent = nullptr;
   label = nullptr;
@@ -147,22 +168,37 @@ lvppBase::lvppBase(const char* fName, const char* oType) {
 
   if (oType)
     setObjType(oType);
-
-  lv_style_init(&style_obj);
 }
 
 lvppBase::~lvppBase() {
+    // Detach before releasing so a style freed by the registry is never referenced by obj.
+    if (pSharedStyle) {
+      if (obj)
+        lv_obj_remove_style(obj, &pSharedStyle->style, LV_PART_MAIN | LV_STATE_DEFAULT);
+      lvppStyleRegistry::release(pSharedStyle);
+      pSharedStyle = nullptr;
+    }
+
+    if (pSignals) {
+      // A listener may be deleting us from inside emit() - release() then leaves it to emit().
+      pSignals->release();
+      pSignals = nullptr;
+    }
+
+    // LVGL may already have deleted our objects (e.g. the whole screen was deleted). In that
+    // case the LV_EVENT_DELETE handling has nulled these pointers and there is nothing to do.
+    // Otherwise unhook our callbacks first so LVGL never calls back into a destroyed wrapper.
     if (adjLabel) {
+      lv_obj_remove_event_cb(adjLabel, &lvppBase::lvDeleteCallback);
       lv_obj_del_async(adjLabel);
       adjLabel = nullptr;
     }
 
-    if (label) {
-      lv_obj_del_async(label);
-      label = nullptr;
-    }
+    // label is always a child of obj (or obj itself for lvppLabel) and goes away with obj.
+    label = nullptr;
 
     if (obj) {
+      lv_obj_remove_event_cb(obj, &lvppBase::lvCallback);
       lv_obj_del_async(obj);
       obj = nullptr;
     }
@@ -180,6 +216,29 @@ void lvppBase::createLabel() {
 void lvppBase::createAdjLabel() {
     if (!adjLabel) {
         adjLabel = lv_label_create(objParent);
+        trackDeletion(adjLabel);
+    }
+}
+
+void lvppBase::trackDeletion(lv_obj_t* o) {
+    lv_obj_add_event_cb(o, &lvppBase::lvDeleteCallback, LV_EVENT_DELETE, this);
+}
+
+void lvppBase::lvDeleteCallback(lv_event_t* event) {
+  lvppBase* pBase = (lvppBase*)lv_event_get_user_data(event);
+  assert(pBase);
+
+  pBase->onLvObjDeleted(lv_event_get_target(event));
+}
+
+void lvppBase::onLvObjDeleted(lv_obj_t* o) {
+    if (o == adjLabel) {
+        adjLabel = nullptr;
+    }
+    else if (o == obj) {
+        // label is a child of obj (or is obj) so it is gone as well. Shared style goes with it.
+        obj = nullptr;
+        label = nullptr;
     }
 }
 
@@ -188,14 +247,22 @@ void lvppBase::align(lv_align_t align, lv_coord_t x_ofs, lv_coord_t y_ofs)
     lv_obj_align(obj, align, x_ofs, y_ofs);
 }
 
+bool lvppBase::setLabelTextIfChanged(lv_obj_t* lbl, const char* pText) {
+    const char* pCur = lv_label_get_text(lbl);
+
+    if (pCur && !strcmp(pCur, pText)) {
+        skippedLabelUpdates++;
+        return false;
+    }
+
+    lv_label_set_text(lbl, pText);
+    return true;
+}
+
 void lvppBase::setText(const char* pText) {
+    LVPP_TRACE_SCOPE("setText");
     createLabel();
-    if (pText) {
-        lv_label_set_text(label, pText);
-    }
-    else {
-        lv_label_set_text(label, "");
-    }
+    setLabelTextIfChanged(label, pText ? pText : "");
 }
 
 std::string lvppBase::getText() {
@@ -214,11 +281,10 @@ void lvppBase::setTextAlign(lv_align_t align, lv_coord_t xoff, lv_coord_t yoff)
 }
 
 void lvppBase::setTextColor(lv_color_t newColor) {
-    if (label) {
-        lv_style_set_text_color(&style_obj, newColor);
-        lv_obj_add_style(label, &style_obj, 0);
+    // The text lives in the child label. The shared style is on obj, so putting the color there
+    // would recolor the widget's own parts too - style the label alone.
+    if (label)
         lv_obj_set_style_text_color(label, newColor, 0);
-    }
 }
 
 void lvppBase::setLabelJustificationAlignment(lv_text_align_t _align) {
@@ -236,7 +302,7 @@ void lvppBase::setLabelColorizationEnabled(bool bEnable) {
 void lvppBase::setAdjText(const char* pText, lv_coord_t x_ofs, lv_coord_t y_ofs) {
     createAdjLabel();
     if (pText) {
-        lv_label_set_text(adjLabel, pText);
+        setLabelTextIfChanged(adjLabel, pText);
     }
     if (x_ofs!=-10000 && y_ofs!=-10000) {
         lv_obj_align_to(adjLabel, obj, LV_ALIGN_CENTER, x_ofs, y_ofs);
@@ -286,7 +352,8 @@ void lvppBase::createObj(lv_obj_t* o) {
         throw;
     
     obj = o;
-    lv_obj_add_style(obj, &style_obj, 0);
+    if (pSharedStyle)
+        lv_obj_add_style(obj, &pSharedStyle->style, LV_PART_MAIN | LV_STATE_DEFAULT);
 
     lv_obj_set_user_data(obj, this);
 
@@ -307,6 +374,7 @@ void lvppBase::lvCallback(lv_event_t* event) {
 }
 
 void lvppBase::baseEventHandler(lv_event_t* event) {
+    LVPP_TRACE_SCOPE("baseEventHandler");
     lv_event_code_t code = lv_event_get_code(event);
 
 #ifdef LOG_EVENTS
@@ -325,21 +393,34 @@ void lvppBase::baseEventHandler(lv_event_t* event) {
 //            printf("%s: CALLING onClicked()...\n", whoAmI());
             internalOnClicked();
             onClicked();
-            if (cbOnClicked)
-                cbOnClicked();
             break;
         case LV_EVENT_VALUE_CHANGED:
 //            printf("%s: CALLING onValueChanged()...\n", whoAmI());
             internalOnValueChanged();
             onValueChanged();
-            if (cbOnValueChanged)
-                cbOnValueChanged();
+            break;
+        case LV_EVENT_DELETE:
+            // Derived class first, while obj is still valid. Then forget the pointers.
+            eventHandler(event);
+            if (lv_event_get_target(event) == obj)
+                onLvObjDeleted(obj);
             break;
         default:
             // Call derived class
             eventHandler(event);
             break;
     }
+
+    // Lambda listeners always run after the class' own handling of the event.
+    if (pSignals)
+        pSignals->emit(code);
+}
+
+bool lvppBase::disconnect(lvppConnection c) {
+    if (!pSignals)
+        return false;
+
+    return pSignals->disconnect(c);
 }
 
 void lvppBase::setSize(lv_coord_t width, lv_coord_t height) {
@@ -351,7 +432,12 @@ void lvppBase::setSize(lv_coord_t width, lv_coord_t height) {
 
 void lvppBase::setFriendlyName(const char* pName) {
     if (pName) {
+        // Keep any owning screen's name index current.
+        if (pOwnerScreen)
+            pOwnerScreen->unindexObject(this);
         friendlyName = pName;
+        if (pOwnerScreen)
+            pOwnerScreen->indexObject(this);
     }
 }
 
@@ -424,18 +510,234 @@ const char* lvppBase::getEventName(lv_event_code_t code) {
 
 void lvppBase::setNewParent(lv_obj_t* pNewParent) {
     objParent = pNewParent;
-    // Main object needs this new pointer.
-    lv_obj_set_parent(obj, pNewParent);
+    // Main object needs this new pointer. Objects created directly under their screen already
+    // have it - skip the re-parent and the invalidation/relayout it brings.
+    if (lv_obj_get_parent(obj) != pNewParent)
+        lv_obj_set_parent(obj, pNewParent);
     // Label's parent is 'obj' so don't reset that.
 
     // If adjlabel exists, set its parent here
     // This is due to the fact that adjLabel's parent is not the main object
     // so that it can be moved outside the boundaries of the main object.
-    if (adjLabel) {
+    if (adjLabel && lv_obj_get_parent(adjLabel) != pNewParent) {
         lv_obj_set_parent(adjLabel, pNewParent);
     }
 }
 
+//
+//
+// l v p p E v e n t S i g n a l s
+//
+//
+
+bool lvppEventSignals::disconnect(lvppConnection c) {
+    if (!c)
+        return false;
+
+    for (auto& s: slots) {
+        if (s.id == c) {
+            s.id = 0;
+            // A callback can disconnect itself - don't destroy it out from under the running call.
+            if (emitDepth)
+                bNeedsCleanup = true;
+            else
+                s.cb.reset();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void lvppEventSignals::release() {
+    if (emitDepth)
+        bOrphaned = true;
+    else
+        delete this;
+}
+
+void lvppEventSignals::emit(lv_event_code_t code) {
+    emitDepth++;
+    for (auto& s: slots) {
+        if (s.id && s.bArmed && s.code == code)
+            s.cb();
+        // The listener deleted the widget - nobody is left to hear the rest.
+        if (bOrphaned)
+            break;
+    }
+    emitDepth--;
+
+    if (bOrphaned) {
+        if (!emitDepth)
+            delete this;
+        return;
+    }
+
+    if (!emitDepth && bNeedsCleanup) {
+        for (auto& s: slots) {
+            if (!s.id)
+                s.cb.reset();
+            else
+                s.bArmed = true;
+        }
+        bNeedsCleanup = false;
+    }
+}
+
+uint8_t lvppEventSignals::getListenerCount(lv_event_code_t code) {
+    uint8_t count = 0;
+
+    for (auto& s: slots) {
+        if (s.id && s.code == code)
+            count++;
+    }
+
+    return count;
+}
+
+//
+//
+// l v p p V a l u e F o r m a t
+//
+//
+
+bool lvppValueFormat::compile(const char* fmt, uint8_t _decimals) {
+    const char* p = fmt;
+    bool bFoundConversion = false;
+
+    bCompiled = false;
+    prefixLen = suffixLen = 0;
+    width = 0;
+    bLeftJustify = bZeroPad = bPlusSign = bSpaceSign = false;
+
+    if (!fmt || _decimals > 4)
+        return false;
+    decimals = _decimals;
+
+    // Anything before the conversion goes straight into buf. Everything after it into suffix.
+    while (*p) {
+        char* pOut = bFoundConversion ? suffix : buf;
+        uint8_t& outLen = bFoundConversion ? suffixLen : prefixLen;
+
+        if (*p != '%') {
+            if (outLen >= VALUELABEL_BUF_SIZE-1)
+                return false;
+            pOut[outLen++] = *p++;
+            continue;
+        }
+
+        p++;
+        if (*p == '%') {
+            if (outLen >= VALUELABEL_BUF_SIZE-1)
+                return false;
+            pOut[outLen++] = '%';
+            p++;
+            continue;
+        }
+
+        // Only a single integer conversion is supported.
+        if (bFoundConversion)
+            return false;
+
+        for (;; p++) {
+            if (*p == '-')
+                bLeftJustify = true;
+            else if (*p == '0')
+                bZeroPad = true;
+            else if (*p == '+')
+                bPlusSign = true;
+            else if (*p == ' ')
+                bSpaceSign = true;
+            else
+                break;
+        }
+
+        // Parsed wide so a long width can't wrap uint8_t back into range before the check.
+        uint32_t w = 0;
+        while (*p >= '0' && *p <= '9') {
+            w = w*10 + (*p - '0');
+            if (w >= VALUELABEL_BUF_SIZE)
+                return false;
+            p++;
+        }
+        width = (uint8_t)w;
+
+        // Allow 'h' length modifiers since the value is an int16_t anyway.
+        while (*p == 'h')
+            p++;
+
+        if (*p != 'd' && *p != 'i')
+            return false;
+        p++;
+        bFoundConversion = true;
+    }
+
+    if (!bFoundConversion)
+        return false;
+
+    // Worst case number is sign + 5 digits + '.' + leading "0" for fractions: "-0.0001" or "-32768".
+    uint8_t maxNumLen = decimals ? 6 + 2 : 6;
+    if (width > maxNumLen)
+        maxNumLen = width;
+    if (prefixLen + maxNumLen + suffixLen + 1 > VALUELABEL_BUF_SIZE)
+        return false;
+
+    buf[prefixLen] = 0;
+    bCompiled = true;
+    return true;
+}
+
+const char* lvppValueFormat::render(int16_t value) {
+    char digits[8];     // Built in reverse.
+    uint8_t nDigits = 0;
+    uint16_t mag = value < 0 ? (uint16_t)(-(int32_t)value) : (uint16_t)value;
+    char sign = 0;
+
+    assert(bCompiled);
+
+    if (value < 0)
+        sign = '-';
+    else if (bPlusSign)
+        sign = '+';
+    else if (bSpaceSign)
+        sign = ' ';
+
+    // Digits (least significant first) with the decimal point dropped in after 'decimals' digits.
+    // Always produce at least one integer digit so 5 with 2 decimals is "0.05".
+    do {
+        if (decimals && nDigits == decimals)
+            digits[nDigits++] = '.';
+        digits[nDigits++] = '0' + (mag % 10);
+        mag /= 10;
+    } while (mag || nDigits <= decimals);
+
+    uint8_t numLen = nDigits + (sign ? 1 : 0);
+    uint8_t pad = width > numLen ? width - numLen : 0;
+    char* pOut = buf + prefixLen;
+
+    if (!bLeftJustify && !bZeroPad) {
+        memset(pOut, ' ', pad);
+        pOut += pad;
+    }
+    if (sign)
+        *pOut++ = sign;
+    if (!bLeftJustify && bZeroPad) {
+        memset(pOut, '0', pad);
+        pOut += pad;
+    }
+    while (nDigits)
+        *pOut++ = digits[--nDigits];
+    if (bLeftJustify) {
+        memset(pOut, ' ', pad);
+        pOut += pad;
+    }
+
+    memcpy(pOut, suffix, suffixLen);
+    pOut[suffixLen] = 0;
+
+    return buf;
+}
+
 //
 //
 // l v p p B a s e W i t h V a l u e
@@ -446,27 +748,55 @@ lvppBaseWithValue::lvppBaseWithValue(const char* fName, const char* oType) : lvp
     valueLabel = nullptr;
     valueLabelFormat = "%d";
     curValue = 0;
+    valueLabelShown = 0;
+    bValueLabelStale = true;
+    valueLabelPlan.compile(valueLabelFormat.c_str());
 
     min=0;
     max=100;
 }
 
+lvppBaseWithValue::~lvppBaseWithValue() {
+    // Lazy screens delete their widgets on unload without the application knowing - so bindings
+    // are dropped here rather than left pointing at a freed widget.
+    while (!boundObservables.empty())
+        boundObservables.back()->unbind(this);
+
+    if (valueLabel) {
+        // The label may be pointing at valueLabelPlan's buffer. Point it at a literal
+        // before the (asynchronous) delete so it never sees freed memory.
+        lv_obj_remove_event_cb(valueLabel, &lvppBase::lvDeleteCallback);
+        lv_label_set_text_static(valueLabel, "");
+        lv_obj_del_async(valueLabel);
+        valueLabel = nullptr;
+    }
+}
+
 /** @todo TECHDEBT - should allow values outside range, but UI only shows inside range.
  *        However, this will impact the 'percentage' function too and likely needs to become getUIPercentage
  * 
 */
 void lvppBaseWithValue::setValue(int16_t value, bool animate)
 {
-    if (value >= min && value <= max) {
-        curValue = value;
-        baseSetter(value, animate);
+    LVPP_TRACE_SCOPE("setValue");
+    if (storeValue(value, animate))
         lv_event_send(obj, LV_EVENT_VALUE_CHANGED, NULL);
-    }
+}
+
+bool lvppBaseWithValue::storeValue(int16_t value, bool animate) {
+    if (value < min || value > max)
+        return false;
+
+    curValue = value;
+    baseSetter(value, animate);
+    return true;
 }
 
 void lvppBaseWithValue::createValueLabel() {
     if (!valueLabel) {
         valueLabel = lv_label_create(objParent);
+        trackDeletion(valueLabel);
+        bValueLabelStale = true;
     }
 }
 
@@ -484,9 +814,19 @@ void lvppBaseWithValue::setValueLabelFont(const lv_font_t* pF) {
     lv_obj_invalidate(valueLabel);
 }
 
-void lvppBaseWithValue::setValueLabelFormat(const char* fmt) {
+void lvppBaseWithValue::setValueLabelFormat(const char* fmt, uint8_t fixedPointDecimals) {
     if (fmt) {
+        // valueLabel may be showing valueLabelPlan's buffer (lv_label_set_text_static), so compile
+        // aside and only swap in once complete - then re-render straight away.
+        lvppValueFormat plan;
         valueLabelFormat = fmt;
+        if (!plan.compile(fmt, fixedPointDecimals)) {
+            LV_LOG_INFO("lvppBaseWithValue::setValueLabelFormat - format not precompiled. Using printf-style formatting.\n");
+        }
+        valueLabelPlan = plan;
+        bValueLabelStale = true;
+        if (valueLabel)
+            internalOnValueChanged();
     }
 }
 
@@ -532,14 +872,36 @@ void lvppBaseWithValue::internalOnValueChanged() {
     curValue = baseGetter();
 
     if (valueLabel) {
-        lv_label_set_text_fmt(valueLabel, valueLabelFormat.c_str(), curValue);
+        // Status screens commonly re-send the same value every tick. Nothing to redraw then.
+        if (!bValueLabelStale && curValue == valueLabelShown) {
+            skippedLabelUpdates++;
+            return;
+        }
+
+        if (valueLabelPlan.isCompiled()) {
+            lv_label_set_text_static(valueLabel, valueLabelPlan.render(curValue));
+        }
+        else {
+            lv_label_set_text_fmt(valueLabel, valueLabelFormat.c_str(), curValue);
+        }
         lv_obj_invalidate(valueLabel);
+        valueLabelShown = curValue;
+        bValueLabelStale = false;
     }
 }
 
+void lvppBaseWithValue::onLvObjDeleted(lv_obj_t* o) {
+    if (o == valueLabel) {
+        valueLabel = nullptr;
+        return;
+    }
+
+    lvppBase::onLvObjDeleted(o);
+}
+
 void lvppBaseWithValue::setNewParent(lv_obj_t* pNewParent) {
     // If valuelabel exists, set its parent
-    if (valueLabel) {
+    if (valueLabel && lv_obj_get_parent(valueLabel) != pNewParent) {
         lv_obj_set_parent(valueLabel, pNewParent);
     }
 
@@ -554,32 +916,27 @@ void lvppBaseWithValue::setNewParent(lv_obj_t* pNewParent) {
 //
 
 void lvppOptions::setOptions(const char* pOpts) {
-    std::string currentLine;
-    const char* currentChar = pOpts;
-
     if (!pOpts) {
         LV_LOG_WARN("lvppOptions::setOptions - argument is nullptr. Not setting.\n");
         return;
     }
 
+    // The clear and the adds below reach the widget once, at the commit.
+    beginOptionsUpdate();
     clearOptions();
 
-    // Rip through the pOpts string and add strings ending in \n to options.
-    while (*currentChar != '\0') {
-        if (*currentChar == '\n') {
-            // When we get to a newline...put the current line in options.
-            options.push_back(currentLine);
-            currentLine.clear();
-        } else {
-            // Add character to the end of the current line until we get a newline
-            currentLine += *currentChar;
+    // Rip through the pOpts string and add each newline terminated line to options.
+    const char* pLine = pOpts;
+    while (*pLine != '\0') {
+        const char* pEnd = strchr(pLine, '\n');
+        if (!pEnd) {
+            // Last line without a trailing '\n'
+            options.emplace_back(pLine);
+            break;
         }
-        currentChar++;
-    }
-    
-    // Add the last line if it doesn't end with '\n'
-    if (!currentLine.empty()) {
-        options.push_back(currentLine);
+
+        options.emplace_back(pLine, pEnd - pLine);
+        pLine = pEnd + 1;
     }
 
     // Set all of the ID values to the index value since they aren't being used otherwise here.
@@ -587,11 +944,16 @@ void lvppOptions::setOptions(const char* pOpts) {
         idList.push_back((uint64_t)i);
     }
 
-    lvOptionSetter(getNewlineSepOptions());
+    optionsChanged();
+    commitOptionsUpdate();
 }
 
 void lvppOptions::setOptionsWithIDs(std::vector<std::pair<std::string, uint64_t>>& valIDs) {
     options.clear();
+    idList.clear();
+    source = nullptr;
+    options.reserve(valIDs.size());
+    idList.reserve(valIDs.size());
 //    printf("setOptionsWithIDs: Pair-size inbound: %lu\n", valIDs.size());
     for (unsigned int i=0; i<valIDs.size(); i++) {
         options.push_back(valIDs[i].first);
@@ -600,39 +962,42 @@ void lvppOptions::setOptionsWithIDs(std::vector<std::pair<std::string, uint64_t>
     }
 //    printf("setOptionsWithIDs after add:\n");
 //    printList();
-    lvOptionSetter(getNewlineSepOptions());
+    optionsChanged();
 }
 
 void lvppOptions::setOptions(std::vector<std::string>& _opts) {
     options = _opts;
+    source = nullptr;
 
     // Set all of the ID values to the index value since they aren't being used otherwise here.
+    idList.clear();
+    idList.reserve(options.size());
     for (unsigned int i=0; i<options.size(); i++) {
         idList.push_back((uint64_t)i);
     }
 
-    lvOptionSetter(getNewlineSepOptions());
+    optionsChanged();
 }
 
 void lvppOptions::addOption(const char* pOpt) {
     options.push_back(pOpt);
     idList.push_back((uint64_t)(options.size()-1));
 
-    lvOptionSetter(getNewlineSepOptions());
+    optionsChanged(options.back().c_str());
 }
 
 void lvppOptions::addOption(std::string& _opt) {
     options.push_back(_opt);
     idList.push_back((uint64_t)(options.size()-1));
 
-    lvOptionSetter(getNewlineSepOptions());
+    optionsChanged(options.back().c_str());
 }
 
 void lvppOptions::addOptionWithID(const char* pOpt, uint64_t id) {
     options.push_back(pOpt);
     idList.push_back((uint64_t)id);
 
-    lvOptionSetter(getNewlineSepOptions());
+    optionsChanged(options.back().c_str());
 }
 
 void lvppOptions::printList(void) {
@@ -647,34 +1012,400 @@ void lvppOptions::addOptionWithID(std::string& _opt, uint64_t id) {
     options.push_back(_opt);
     idList.push_back((uint64_t)id);
 
-    lvOptionSetter(getNewlineSepOptions());
+    optionsChanged(options.back().c_str());
 }
 
 void lvppOptions::clearOptions() {
     options.clear();
     idList.clear();
+    source = nullptr;
+    sourceCount = 0;
+
+    optionsChanged();
+}
+
+void lvppOptions::optionsChanged(const char* pAppended) {
+    // Appends keep the ID index current (emplace keeps the first index of a duplicate ID, as a
+    // linear search would). Anything else rebuilds it on demand.
+    if (pAppended && bIdIndexValid && !idList.empty())
+        idIndex.emplace(idList.back(), (uint32_t)(idList.size()-1));
+    else
+        invalidateIdIndex();
+    invalidateSearchIndex();
+
+    if (bulkDepth) {
+        bOptionsDirty = true;
+        return;
+    }
+
+    if (pAppended && !isVirtual() && !bFilterActive && lvOptionAppender(pAppended))
+        return;
+
+    applyOptionsToWidget();
+}
+
+void lvppOptions::applyOptionsToWidget() {
+    LVPP_TRACE_SCOPE("optionsRebuild");
+    if (bFilterActive && !bFilterValid)
+        runFilter(filterText, false);
+
+    if (isVirtual())
+        materializeWindow(windowStart + lvOptionGetIndex());
+    else
+        lvOptionSetter(getViewString());
+}
+
+// The newline separated options currently shown - all, or the filter's matches.
+const char* lvppOptions::getViewString() {
+    if (!bFilterActive)
+        return getNewlineSepOptions();
+
+    oneString.clear();
+    for (auto it: filtered) {
+        if (!oneString.empty())
+            oneString += '\n';
+        oneString += options[it];
+    }
+
+    return oneString.c_str();
+}
+
+// Show the current view in the widget with view position pos selected.
+void lvppOptions::setWidgetView(uint32_t pos) {
+    if (isVirtual()) {
+        materializeWindow(pos);
+        return;
+    }
+
+    windowStart = 0;
+    lvOptionSetter(getViewString());
+    if (pos < getVisibleCount())
+        lvOptionSetIndex(pos);
+}
+
+bool lvppOptions::indexToView(uint32_t index, uint32_t& pos) {
+    if (!bFilterActive) {
+        pos = index;
+        return index < getOptionCount();
+    }
+
+    auto it = std::lower_bound(filtered.begin(), filtered.end(), index);
+    if (it == filtered.end() || *it != index)
+        return false;
+
+    pos = it - filtered.begin();
+    return true;
+}
+
+void lvppOptions::setVirtualWindow(uint16_t rows) {
+    uint32_t selected = windowStart + lvOptionGetIndex();
+
+    if (!rows && source) {
+        LV_LOG_WARN("lvppOptions::setVirtualWindow - an option source requires virtual mode.\n");
+        return;
+    }
+
+    windowRows = rows;
+    setWidgetView(selected);
+}
+
+void lvppOptions::setOptionSource(uint32_t count, lvppOptionSource _source) {
+    uint32_t selected = getSelectedOptionIndex();
+
+    options.clear();
+    idList.clear();
+    invalidateIdIndex();
+    invalidateSearchIndex();
+    bFilterActive = false;
+    filtered.clear();
+    source = _source;
+    sourceCount = _source ? count : 0;
+
+    if (!isVirtual())
+        windowRows = LVPP_OPTIONS_WINDOW_ROWS;
+    materializeWindow(selected);
+}
+
+const char* lvppOptions::getOptionText(uint32_t index, uint64_t* pID) {
+    if (source) {
+        const char* pText = source(index, pID);
+        return pText ? pText : "";
+    }
+
+    if (pID)
+        *pID = index < idList.size() ? idList[index] : LVPP_OPTIONS_NO_ID;
+    return options[index].c_str();
+}
+
+//
+// Give the widget only the rows around center (clamped to the list) and select center in it.
+//
+void lvppOptions::materializeWindow(uint32_t center) {
+    uint32_t count = getVisibleCount();
+    uint32_t rows = windowRows < count ? windowRows : count;
+
+    if (center >= count)
+        center = count ? count-1 : 0;
+
+    uint32_t start = center > rows/2 ? center - rows/2 : 0;
+    if (start + rows > count)
+        start = count - rows;
+
+    oneString.clear();
+    for (uint32_t i=start; i<start+rows; i++) {
+        if (i != start)
+            oneString += '\n';
+        oneString += getOptionText(viewToIndex(i));
+    }
+
+    windowStart = start;
+    lvOptionSetter(oneString.c_str());
+    if (count)
+        lvOptionSetIndex(center - start);
+}
+
+void lvppOptions::onWidgetIndexChanged() {
+    if (!isVirtual())
+        return;
+
+    uint32_t count = getVisibleCount();
+    uint32_t rows = windowRows < count ? windowRows : count;
+    uint32_t ind = lvOptionGetIndex();
+    uint32_t margin = rows / 4;
+
+    // Recenter before the user can run out of rows in either direction.
+    if ((ind < margin && windowStart > 0) || (ind + margin >= rows && windowStart + rows < count))
+        materializeWindow(windowStart + ind);
+}
+
+bool lvppOptions::selectOption(uint32_t index) {
+    uint32_t pos;
+
+    if (!indexToView(index, pos))
+        return false;
+
+    if (isVirtual())
+        materializeWindow(pos);
+    else
+        lvOptionSetIndex(pos);
+
+    return true;
+}
+
+void lvppOptions::invalidateSearchIndex() {
+    bLowerValid = false;
+    bPrefixIndexValid = false;
+    bTrigramIndexValid = false;
+    bFilterValid = false;
+    lowerOptions.clear();
+    prefixOrder.clear();
+    trigrams.clear();
+}
+
+static void toLowerAscii(std::string& s) {
+    for (auto& c: s) {
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+    }
+}
 
-    lvOptionSetter(getNewlineSepOptions());
+void lvppOptions::buildLowerOptions() {
+    if (bLowerValid)
+        return;
+
+    lowerOptions = options;
+    for (auto& it: lowerOptions)
+        toLowerAscii(it);
+    bLowerValid = true;
+}
+
+void lvppOptions::buildPrefixIndex() {
+    if (bPrefixIndexValid)
+        return;
+
+    buildLowerOptions();
+    prefixOrder.resize(lowerOptions.size());
+    for (uint32_t i=0; i<prefixOrder.size(); i++)
+        prefixOrder[i] = i;
+    std::sort(prefixOrder.begin(), prefixOrder.end(),
+              [this](uint32_t a, uint32_t b) { return lowerOptions[a] < lowerOptions[b]; });
+    bPrefixIndexValid = true;
+}
+
+static inline uint32_t trigramKey(const char* p) {
+    return ((uint32_t)(uint8_t)p[0] << 16) | ((uint32_t)(uint8_t)p[1] << 8) | (uint8_t)p[2];
+}
+
+void lvppOptions::buildTrigramIndex() {
+    if (bTrigramIndexValid)
+        return;
+
+    buildLowerOptions();
+    trigrams.clear();
+    for (uint32_t i=0; i<lowerOptions.size(); i++) {
+        const std::string& opt = lowerOptions[i];
+        for (size_t c=0; c+3 <= opt.size(); c++) {
+            // Options are visited in order, so each list stays ascending; skip repeats within an option.
+            std::vector<uint32_t>& postings = trigrams[trigramKey(opt.c_str()+c)];
+            if (postings.empty() || postings.back() != i)
+                postings.push_back(i);
+        }
+    }
+    bTrigramIndexValid = true;
+}
+
+//
+// Fill filtered with the ascending indexes of the options matching text (already lower cased).
+// bNarrow means text extends the previous filter so only its matches need checking.
+//
+void lvppOptions::runFilter(const std::string& text, bool bNarrow) {
+    bool bPrefix = (filterMode == LVPP_FILTER_PREFIX);
+
+    buildLowerOptions();
+
+    if (bNarrow) {
+        size_t kept = 0;
+        for (auto it: filtered) {
+            const std::string& opt = lowerOptions[it];
+            if (bPrefix ? opt.compare(0, text.size(), text) == 0 : opt.find(text) != std::string::npos)
+                filtered[kept++] = it;
+        }
+        filtered.resize(kept);
+    }
+    else if (bPrefix) {
+        buildPrefixIndex();
+        size_t len = text.size();
+        auto lo = std::lower_bound(prefixOrder.begin(), prefixOrder.end(), text,
+                    [this, len](uint32_t a, const std::string& t) { return lowerOptions[a].compare(0, len, t) < 0; });
+        auto hi = std::upper_bound(lo, prefixOrder.end(), text,
+                    [this, len](const std::string& t, uint32_t a) { return lowerOptions[a].compare(0, len, t) > 0; });
+        filtered.assign(lo, hi);
+        std::sort(filtered.begin(), filtered.end());
+    }
+    else if (text.size() >= 3) {
+        // Candidates are the options containing the query's rarest trigram, then checked in full.
+        buildTrigramIndex();
+        const std::vector<uint32_t>* pBest = nullptr;
+        for (size_t c=0; c+3 <= text.size(); c++) {
+            auto it = trigrams.find(trigramKey(text.c_str()+c));
+            if (it == trigrams.end()) {
+                pBest = nullptr;
+                break;
+            }
+            if (!pBest || it->second.size() < pBest->size())
+                pBest = &it->second;
+        }
+
+        filtered.clear();
+        if (pBest) {
+            for (auto it: *pBest) {
+                if (lowerOptions[it].find(text) != std::string::npos)
+                    filtered.push_back(it);
+            }
+        }
+    }
+    else {
+        // One or two characters - too short for trigrams.
+        filtered.clear();
+        for (uint32_t i=0; i<lowerOptions.size(); i++) {
+            if (lowerOptions[i].find(text) != std::string::npos)
+                filtered.push_back(i);
+        }
+    }
+
+    bFilterValid = true;
+}
+
+uint32_t lvppOptions::setFilter(const char* pText, lvppFilterMode mode) {
+    uint32_t selected = getSelectedOptionIndex();
+
+    if (source) {
+        LV_LOG_WARN("lvppOptions::setFilter - not available with an option source.\n");
+        return getOptionCount();
+    }
+
+    if (!pText || !*pText) {
+        if (bFilterActive) {
+            bFilterActive = false;
+            filtered.clear();
+            filterText.clear();
+            setWidgetView(selected < options.size() ? selected : 0);
+        }
+        return getOptionCount();
+    }
+
+    std::string text(pText);
+    toLowerAscii(text);
+
+    // The next keystroke only needs to look at what the last one matched.
+    bool bNarrow = bFilterActive && bFilterValid && mode == filterMode
+                   && text.size() > filterText.size() && text.compare(0, filterText.size(), filterText) == 0;
+
+    filterMode = mode;
+    filterText = text;
+    bFilterActive = true;
+    runFilter(filterText, bNarrow);
+
+    uint32_t pos;
+    if (!indexToView(selected, pos))
+        pos = 0;
+    setWidgetView(pos);
+
+    return filtered.size();
+}
+
+void lvppOptions::commitOptionsUpdate() {
+    if (!bulkDepth) {
+        LV_LOG_WARN("lvppOptions::commitOptionsUpdate - no matching beginOptionsUpdate().\n");
+        return;
+    }
+
+    if (--bulkDepth == 0 && bOptionsDirty) {
+        bOptionsDirty = false;
+        applyOptionsToWidget();
+    }
 }
 
 uint64_t lvppOptions::getSelectedID() {
-    return idList[lvOptionGetIndex()];
+    uint32_t ind = getSelectedOptionIndex();
+    uint64_t id = LVPP_OPTIONS_NO_ID;
+
+    if (ind < getOptionCount())
+        getOptionText(ind, &id);
+
+    return id;
 }
 
 bool lvppOptions::setSelectedID(uint64_t _val) {
-    // Need to find the index of the input _val
-    auto it = std::find(idList.begin(), idList.end(), _val);
-    if (it == idList.end())
+    if (source) {
+        LV_LOG_WARN("lvppOptions::setSelectedID - not available with an option source.\n");
+        return false;
+    }
+
+    if (!bIdIndexValid) {
+        idIndex.clear();
+        idIndex.reserve(idList.size());
+        for (size_t i=0; i<idList.size(); i++)
+            idIndex.emplace(idList[i], (uint32_t)i);
+        bIdIndexValid = true;
+    }
+
+    auto it = idIndex.find(_val);
+    if (it == idIndex.end())
         return false;
     
-    uint16_t ind = it - idList.begin();
-    lvOptionSetIndex(ind);
-    return true;
+    return selectOption(it->second);
 }
 
 const char* lvppOptions::getNewlineSepOptions() {
     bool first=true;
-    oneString = "";
+    size_t len = options.size();    // The newlines (plus one spare).
+
+    // Size it once up front rather than growing it option by option.
+    for (const auto& it: options)
+        len += it.size();
+    oneString.clear();
+    oneString.reserve(len);
 
     for (const auto& it: options) {
         // Prevents final entry from having \n concatenated.
@@ -33,6 +33,7 @@
 #include <utility> // For std::pair
 #include <string>
 #include <functional>
+#include <unordered_map>
 
 #ifdef LV_LVGL_H_INCLUDE_SIMPLE
 #include "lvgl.h"
@@ -40,11 +41,18 @@
 #include "lvgl/lvgl.h"
 #endif
 
+#include "lvppStyle.h"
+#include "lvppSignal.h"
+
+class lvppObservable;
+
 /** @file lvppBase.h
  * @brief Base class for LVGLPlusPlus widgets (lvppBase)
  * 
  */
 
+class lvppScreen;
+
 static std::string eventNames[_LV_EVENT_LAST];  ///< Place to store textual versions of event types.
 
 /**
@@ -79,7 +87,7 @@ public:
  *              via getObjType() if needed.
  */
     lvppBase(const char* fName, const char* oType);
-    ~lvppBase();
+    virtual ~lvppBase();
 /**
  * @brief Create the handlers and store the newly created object.
  * 
@@ -210,7 +218,7 @@ public:
  */
     void setTextAlign(lv_align_t align, lv_coord_t xoff, lv_coord_t yoff);
 /**
- * @brief Set the Text Color of the primary label object
+ * @brief Set the Text Color of the primary label object. Does nothing if there is no label.
  * 
  * @param newColor An lv_color_t for the desired color to use.
  */
@@ -305,53 +313,104 @@ public:
 /**
  * @brief Get the Friendly Name of the object
  * 
- * @return std::string of the internal friendly name of the object.
+ * @return const std::string& of the internal friendly name of the object.
  */
-    std::string getFriendlyName() { return friendlyName; };
+    const std::string& getFriendlyName() { return friendlyName; };
 /**
  * @brief Get the Obj Type
  * 
- * @return std::string of the internal object type. This is what is given in the constructor
+ * @return const std::string& of the internal object type. This is what is given in the constructor
  *         as oType. It can be used to determine the type of an object without the need for
  *         RTTI library support and dynamic_cast<> or other such RTTI support methodologies.
  */
-    std::string getObjType() { return objType; };
+    const std::string& getObjType() { return objType; };
+/**
+ * @brief Set by lvppScreen::addObject() so a change of friendly name can keep the screen's
+ *        name index up to date. Not normally called by users.
+ * 
+ * @param pScr The screen now tracking this object, or nullptr.
+ */
+    void setOwnerScreen(lvppScreen* pScr) { pOwnerScreen = pScr; };
 /**
  * @brief Utility useful for dumping the friendly name and object type if needed.
  * 
  * @return const char* returned `friendlyName(objectType)`
  */
     const char* whoAmI(void);
+/**
+ * @brief Add a lambda (or any callable taking no arguments) to be called when the given LVGL
+ *        event occurs on this object. Any number of listeners (up to LVPP_MAX_LISTENERS in total)
+ *        can be connected per object and per event.
+ * 
+ * Listeners are called after the class' own handling (onClicked(), onValueChanged(), eventHandler())
+ * in slot order - the order they were connected in, except that a slot freed by disconnect() is
+ * reused by the next connect(). A listener may delete this object (e.g. a close button); the
+ * listeners after it are then skipped. Small lambdas are stored inline so no allocation
+ * takes place - at connect time or at dispatch time.
+ * 
+ * @param code The LVGL event code such as LV_EVENT_LONG_PRESSED, LV_EVENT_FOCUSED, LV_EVENT_RELEASED.
+ * @param cbF The callable. Signature is `void()`.
+ * @return lvppConnection handle to pass to disconnect(). 0 if no listener slots remain.
+ */
+    template<typename F>
+    lvppConnection connect(lv_event_code_t code, F&& cbF) {
+        if (!pSignals)
+            pSignals = new lvppEventSignals();
+        return pSignals->connect(code, std::forward<F>(cbF));
+    };
+/**
+ * @brief Remove a listener added via connect() or any of the setCallbackOn*() methods.
+ * 
+ * @param c The handle returned when the listener was added.
+ * @return true if the listener was found and removed.
+ */
+    bool disconnect(lvppConnection c);
 /**
  * @brief Uses a lambda callback for when an object is clicked.
  * 
  * This method allows users to instantiate most objects without deriving their own class
  * from them. They can instantiate the object, set its font, size, alignment, and text all
  * using the built in methods and they can receive a callback through the use of this
- * lambda callback methodology.
+ * lambda callback methodology. Calling it more than once adds additional listeners.
  * 
- * @param cbF This is a std::function<> lambda defining the callback 'inline'.
+ * @param cbF This is a lambda defining the callback 'inline'.
+ * @return lvppConnection handle which can be given to disconnect().
  */
-    void setCallbackOnClicked(std::function<void()> cbF) {
-        assert(!cbOnClicked);
-        assert(cbF);
-        cbOnClicked = cbF;
-    };
+    template<typename F>
+    lvppConnection setCallbackOnClicked(F&& cbF) { return connect(LV_EVENT_CLICKED, std::forward<F>(cbF)); };
 /**
  * @brief Uses a lambda callback for when an object value changes.
  * 
  * This method allows users to instantiate most objects without deriving their own class
  * from them. They can instantiate the object, set its font, size, alignment, and text all
  * using the built in methods and they can receive a callback through the use of this
- * lambda callback methodology.
+ * lambda callback methodology. Calling it more than once adds additional listeners.
  * 
- * @param cbF This is a std::function<> lambda defining the callback 'inline'.
+ * @param cbF This is a lambda defining the callback 'inline'.
+ * @return lvppConnection handle which can be given to disconnect().
  */
-    void setCallbackOnValueChanged(std::function<void()> cbF) {
-        assert(!cbOnValueChanged);
-        assert(cbF);
-        cbOnValueChanged = cbF;
-    };
+    template<typename F>
+    lvppConnection setCallbackOnValueChanged(F&& cbF) { return connect(LV_EVENT_VALUE_CHANGED, std::forward<F>(cbF)); };
+/**
+ * @brief Lambda callback for when the object has been pressed for a long time. See connect().
+ */
+    template<typename F>
+    lvppConnection setCallbackOnLongPressed(F&& cbF) { return connect(LV_EVENT_LONG_PRESSED, std::forward<F>(cbF)); };
+/**
+ * @brief Lambda callback for when the object is released after a press. See connect().
+ */
+    template<typename F>
+    lvppConnection setCallbackOnReleased(F&& cbF) { return connect(LV_EVENT_RELEASED, std::forward<F>(cbF)); };
+/**
+ * @brief Lambda callback for when the object gains focus. See connect().
+ */
+    template<typename F>
+    lvppConnection setCallbackOnFocused(F&& cbF) { return connect(LV_EVENT_FOCUSED, std::forward<F>(cbF)); };
+/**
+ * @brief Lambda callback for when the object loses focus. See connect().
+ */
+    template<typename F>
+    lvppConnection setCallbackOnDefocused(F&& cbF) { return connect(LV_EVENT_DEFOCUSED, std::forward<F>(cbF)); };
 
 /**
  * @brief Changes the parent object on the fly. Used primarily for lvppScreen::addObject().
@@ -360,17 +419,36 @@ public:
  * @param pNewParent pointer to the new parent.
  */
     virtual void setNewParent(lv_obj_t* pNewParent);
+/**
+ * @brief Number of label updates (text or value label) which were skipped because the
+ *        label already showed exactly what was requested. Counted across all widgets.
+ * 
+ * @return uint32_t count of skipped updates since start or since resetSkippedLabelUpdates().
+ */
+    static uint32_t getSkippedLabelUpdates() { return skippedLabelUpdates; };
+/**
+ * @brief Zero the counter returned by getSkippedLabelUpdates().
+ * 
+ */
+    static void resetSkippedLabelUpdates() { skippedLabelUpdates = 0; };
 protected:
     lv_obj_t* label;    ///< Primary label.
     lv_obj_t* adjLabel; ///< For items that have a label 'nearby' (adjacent label)
-    std::function<void()> cbOnClicked=nullptr;      ///< Start without a lambda callback
-    std::function<void()> cbOnValueChanged=nullptr; ///< Start without a lambda callback
+    lvppEventSignals* pSignals;     ///< Lambda listeners. Only allocated once the first one is connected.
+    lvppScreen* pOwnerScreen=nullptr;   ///< Screen whose name index includes this object (if any).
     lv_obj_t* obj;      ///< The LVGL object that was created for this widget
     lv_obj_t* objParent;    ///< Any parent object (following same principle as LVGL here)
     std::string objType;
     std::string friendlyName;
-    lv_style_t style_obj;   ///< Main style object - unsure if I'm handling all of the style bit correctly.
+    lvppStyleProps styleProps;              ///< Style properties this widget wants on its main object.
+    lvppSharedStyle* pSharedStyle=nullptr;  ///< Interned style currently attached to obj (shared with identical widgets).
     void setObjType(const char* pType) { objType = pType; };
+/**
+ * @brief Attach the shared style matching styleProps to obj, replacing any prior shared style.
+ *        Call after changing styleProps. Widgets with identical props share one lv_style_t.
+ * 
+ */
+    void applySharedStyle();
 
 /**
  * @brief Main event handler loop for all events. This handler makes calls for onClicked() and onValueChanged()
@@ -391,6 +469,27 @@ protected:
  * @param event An LVGL lv_event_t event object pointer to be handled.
  */
     static void lvCallback(lv_event_t* event);
+/**
+ * @brief Static member receiving LV_EVENT_DELETE for ancillary LVGL objects (adjacent label,
+ *        value label) which don't otherwise route events to the C++ object.
+ * 
+ * @param event An LVGL lv_event_t event object pointer to be handled.
+ */
+    static void lvDeleteCallback(lv_event_t* event);
+/**
+ * @brief Have LVGL tell us (via onLvObjDeleted()) when it deletes o. Used for objects which are
+ *        not children of obj - for instance when their parent screen is deleted.
+ * 
+ * @param o The LVGL object to watch.
+ */
+    void trackDeletion(lv_obj_t* o);
+/**
+ * @brief LVGL deleted one of our objects. Forget the pointer so the destructor won't touch it.
+ *        Derived classes holding their own top-level LVGL objects override and chain to this.
+ * 
+ * @param o The LVGL object being deleted.
+ */
+    virtual void onLvObjDeleted(lv_obj_t* o);
 /**
  * @brief One-time initialization of the event names array.
  * 
@@ -398,6 +497,16 @@ protected:
     static void initEventNames(void);
 
     static bool bEventNamesInitComplete;    ///< Status of the event names table to avoid re-processing.
+/**
+ * @brief Set the text of an LVGL label only if it differs from what the label already holds.
+ *        Skipping avoids LVGL reallocating the text, recomputing layout and invalidating the label.
+ * 
+ * @param lbl The LVGL label object to update.
+ * @param pText New text. Must not be nullptr.
+ * @return true if the label was changed, false if the update was skipped.
+ */
+    static bool setLabelTextIfChanged(lv_obj_t* lbl, const char* pText);
+    static uint32_t skippedLabelUpdates;    ///< Statistics - see getSkippedLabelUpdates()
 private:
     void createLabel();
     void createAdjLabel();
@@ -409,6 +518,50 @@ private:
 //
 //
 
+constexpr uint8_t VALUELABEL_BUF_SIZE = 32;   ///< Bytes reserved in each widget for its rendered value label.
+
+/**
+ * @brief A value label format which has been 'precompiled' from its printf-style form.
+ * 
+ * setValueLabelFormat() formats such as "Speed: %+4d km/h" are broken down once into a prefix,
+ * an integer field (flags and width) and a suffix. Rendering a value then just writes the digits
+ * and suffix into a fixed buffer - no vsnprintf and no heap allocation - and the buffer is handed
+ * to LVGL via lv_label_set_text_static(). An optional fixed-point scale lets an integer value of
+ * 215 with 1 decimal render as "21.5".
+ * 
+ * Formats which can't be precompiled (anything other than one %d / %i conversion, or results
+ * that could exceed VALUELABEL_BUF_SIZE) report isCompiled()==false and the caller falls back
+ * to lv_label_set_text_fmt().
+ */
+class lvppValueFormat {
+public:
+    lvppValueFormat() { buf[0] = 0; };
+/**
+ * @brief Break down a printf-style format containing a single %d (or %i).
+ *        Supported flags are '-', '+', ' ', and '0' along with a field width. `%%` is a literal '%'.
+ * 
+ * @param fmt The printf-style format.
+ * @param decimals Fixed-point scale. The value is divided by 10^decimals when rendered. Max 4.
+ * @return true if the format was precompiled. false means the caller must use fmt as-is.
+ */
+    bool compile(const char* fmt, uint8_t decimals=0);
+/**
+ * @brief Render value into the internal buffer. Only valid when isCompiled().
+ * 
+ * @return const char* the internal buffer - stable for the life of this object.
+ */
+    const char* render(int16_t value);
+    bool isCompiled() { return bCompiled; };
+protected:
+    char buf[VALUELABEL_BUF_SIZE];          ///< Prefix is written once at compile(). Digits + suffix follow it.
+    char suffix[VALUELABEL_BUF_SIZE];       ///< Text following the conversion.
+    uint8_t prefixLen=0, suffixLen=0;
+    uint8_t width=0;                        ///< Minimum field width of the number, printf style.
+    uint8_t decimals=0;                     ///< Fixed-point scale (digits after the decimal point).
+    bool bLeftJustify=false, bZeroPad=false, bPlusSign=false, bSpaceSign=false;
+    bool bCompiled=false;
+};
+
 /**
  * @brief Derivation from lvppBase. Those widgets which have an inherant 'value' to show are based on 
  *        this slight modified version of lvppBase which includes a value label and an associated style object.
@@ -426,6 +579,7 @@ public:
  * 
  */
     lvppBaseWithValue(const char* fName, const char* oType);
+    virtual ~lvppBaseWithValue();
 /**
  * @brief Set the Value associated with the object. This is a pure virtual function and
  *        must be overridden and implemented by the derived class. When implementing your
@@ -478,9 +632,14 @@ public:
  *        text before the number and even a '%' after - for instance "Completeness: %d%%".
  *        When the value changes, the class will automatically apply this format with the new value.
  * 
+ * The format is precompiled here (see lvppValueFormat) so that value changes render without
+ * any allocation. Flags and width such as "%+05d" are honored.
+ * 
  * @param fmt A printf-style format to be used when values change in the object.
+ * @param fixedPointDecimals Optional fixed-point scale. With 1, a value of 215 shows as "21.5".
+ *                           Only applies to formats that can be precompiled.
  */
-    void setValueLabelFormat(const char* fmt);
+    void setValueLabelFormat(const char* fmt, uint8_t fixedPointDecimals=0);
 /**
  * @brief Set the Value Label's text Color
  * 
@@ -543,15 +702,59 @@ protected:
  * @param animate If widget supports it, animation to value.
  */
     virtual void baseSetter(int16_t nVal, bool animate=true) = 0;
+/**
+ * @brief setValue() without the LV_EVENT_VALUE_CHANGED - lvppScreen::applyBatch() sends one per
+ *        widget once the whole batch is in.
+ * 
+ * @return true if the value was in range and applied.
+ */
+    bool storeValue(int16_t value, bool animate);
     void internalOnValueChanged();  ///< Internal handler for value change. Does the formatting as well.
+    virtual void onLvObjDeleted(lv_obj_t* o);
     int16_t curValue;               ///< The value we're keeping and handling in this class.
     lv_obj_t* valueLabel;           ///< The label that receives the formatted value if the label is enabled.
     std::string valueLabelFormat;   ///< The format to use when the value changes.
+    lvppValueFormat valueLabelPlan; ///< Precompiled valueLabelFormat. Also owns the label's static text buffer.
+    int16_t valueLabelShown;        ///< The value currently rendered in valueLabel.
+    bool bValueLabelStale;          ///< True when valueLabel must be re-rendered regardless of value.
     int16_t min, max;               ///< The allowable range of the value.
+    friend class lvppObservable;
+    friend class lvppScreen;
+    std::vector<lvppObservable*> boundObservables;  ///< Observables bound to us - unbound in the destructor.
 private:
     void createValueLabel();
 };
 
+/**
+ * @brief Returned by lvppOptions::getSelectedID() when nothing valid is selected.
+ */
+#define LVPP_OPTIONS_NO_ID UINT64_MAX
+
+/**
+ * @brief Default number of rows given to the LVGL widget in virtual mode - see lvppOptions::setVirtualWindow().
+ *        Can be overridden in platform.ini...build_flags with -D LVPP_OPTIONS_WINDOW_ROWS=n
+ */
+#ifndef LVPP_OPTIONS_WINDOW_ROWS
+#define LVPP_OPTIONS_WINDOW_ROWS 21
+#endif
+
+/**
+ * @brief How lvppOptions::setFilter() matches options. Matching ignores (ASCII) case.
+ */
+enum lvppFilterMode : uint8_t {
+    LVPP_FILTER_PREFIX=0,       ///< Options starting with the filter text.
+    LVPP_FILTER_SUBSTRING,      ///< Options containing the filter text anywhere.
+};
+
+/**
+ * @brief Supplies options on demand for lvppOptions::setOptionSource().
+ * 
+ * @param index Zero-based index of the option wanted.
+ * @param pID When non-null, receives the option's ID.
+ * @return const char* The option text. Only needs to stay valid until the next call.
+ */
+typedef std::function<const char*(uint32_t index, uint64_t* pID)> lvppOptionSource;
+
 /** @class lvppOptions
  * @brief _Utility class_ to aid in consistent handling of all lv_ widgets which have
  *        a list of choices. This means _roller_, _dropdown_, and from this library,
@@ -623,17 +826,131 @@ public:
  * @brief Get the ID associated with the currently selected item. Using this method only makes
  *        sense if the list of options was built using setOptionsWithIDs() and/or addOptionWithID().
  * 
- * @return uint64_t the pre-set ID associated with this current selected value/index.
+ * @return uint64_t the pre-set ID associated with this current selected value/index, or
+ *         LVPP_OPTIONS_NO_ID if the selected index has no ID (e.g. the list is empty).
  */
     virtual uint64_t getSelectedID();
 /**
  * @brief Set the ID associated with the currently selected item. Using this method only makes
  *        sense if the list of options was built using setOptionsWithIDs() and/or addOptionWithID().
  * 
+ * The ID is found through a hash index, so this is constant time regardless of list size. If an
+ * ID appears more than once, the first option with it is selected.
+ * 
  * @return true = success ; false = failed due to not finding an entry with the _val value.
  */
     virtual bool setSelectedID(uint64_t _val);
+/**
+ * @brief Start a bulk edit of the options. Until the matching commitOptionsUpdate() the add/set/clear
+ *        methods only change the local lists; the widget is updated once at the end. Calls may nest.
+ * 
+ * Use when adding many options one at a time:
+ *    pDD->beginOptionsUpdate();
+ *    for (auto& row: rows) pDD->addOptionWithID(row.name, row.id);
+ *    pDD->commitOptionsUpdate();
+ */
+    void beginOptionsUpdate() { bulkDepth++; };
+/**
+ * @brief End a bulk edit started by beginOptionsUpdate(). The outermost commit updates the widget
+ *        if anything changed.
+ */
+    void commitOptionsUpdate();
+/**
+ * @brief Virtual mode for very large lists (lvppRoller and lvppDropdown). Only a window of
+ *        rows around the selection is given to LVGL, rather than one label holding every option.
+ *        As the selection moves toward either end of the window, the window is recentered.
+ * 
+ * Indexes and IDs (getSelectedIndex(), getSelectedID(), ...) are always those of the full list.
+ * 
+ * @param rows Number of rows in the window. 0 turns virtual mode off.
+ */
+    void setVirtualWindow(uint16_t rows=LVPP_OPTIONS_WINDOW_ROWS);
+    bool isVirtual() { return windowRows != 0; };
+/**
+ * @brief Fetch options on demand rather than keeping them in the options list. Implies virtual
+ *        mode (see setVirtualWindow()). Call again whenever the count or the data changes.
+ *        clearOptions() or any of the setOptions() methods drop the source.
+ *        setSelectedID() is not available with a source as there is no index of IDs.
+ * 
+ * @param count Number of options the source has.
+ * @param _source Function returning the option text (and ID) for an index.
+ */
+    void setOptionSource(uint32_t count, lvppOptionSource _source);
+/**
+ * @brief Number of options - from the source if one is set.
+ */
+    uint32_t getOptionCount() { return source ? sourceCount : options.size(); };
+/**
+ * @brief Index of the selected option in the full list, also in virtual mode.
+ */
+    uint32_t getSelectedOptionIndex() { return viewToIndex(windowStart + lvOptionGetIndex()); };
+/**
+ * @brief Select an option by its index in the full list, moving the window as needed in virtual mode.
+ * 
+ * @param index Zero-based index.
+ * @return false if index is out of range.
+ */
+    bool selectOption(uint32_t index);
+/**
+ * @brief Show only the options matching pText, e.g. as the user types. Options keep their
+ *        indexes and IDs; the selection stays put if it still matches, otherwise the first match
+ *        is selected.
+ * 
+ * Prefix matching uses a sorted index and substring matching a trigram index, both built on first
+ * use and kept until the options change. A filter which extends the previous one (the next
+ * keystroke) only narrows the previous matches. Not available with setOptionSource().
+ * 
+ * @param pText Filter text. nullptr or "" shows all options again.
+ * @param mode Prefix or substring matching.
+ * @return uint32_t Number of matching options.
+ */
+    uint32_t setFilter(const char* pText, lvppFilterMode mode=LVPP_FILTER_PREFIX);
+/**
+ * @brief Show all options again. Same as setFilter(nullptr).
+ */
+    void clearFilter() { setFilter(nullptr); };
+    bool isFiltered() { return bFilterActive; };
+/**
+ * @brief Number of options currently shown - the matches when filtered, otherwise getOptionCount().
+ */
+    uint32_t getVisibleCount() { return bFilterActive ? filtered.size() : getOptionCount(); };
 protected:
+/**
+ * @brief Optional override to append a single option to the widget without resetting the full
+ *        list, called after pOpt has been added to options. Return false (the default) if the
+ *        widget can't do so, in which case lvOptionSetter() is called with the full list.
+ * 
+ * @param pOpt The option which was added.
+ * @return true if the widget was updated.
+ */
+    virtual bool lvOptionAppender(const char* pOpt) { return false; };
+/**
+ * @brief Bring the widget up to date after options changed - or just note it during a bulk edit.
+ * 
+ * @param pAppended The single option which was appended, if that was the change. Allows lvOptionAppender().
+ */
+    void optionsChanged(const char* pAppended=nullptr);
+/**
+ * @brief Children call this when the user changed the selection so virtual mode can recenter its window.
+ */
+    void onWidgetIndexChanged();
+    void materializeWindow(uint32_t center);
+    void applyOptionsToWidget();
+    const char* getOptionText(uint32_t index, uint64_t* pID=nullptr);
+    uint32_t viewToIndex(uint32_t pos) { return !bFilterActive ? pos : (pos < filtered.size() ? filtered[pos] : UINT32_MAX); };
+    bool indexToView(uint32_t index, uint32_t& pos);
+    const char* getViewString();
+    void setWidgetView(uint32_t pos);
+    void runFilter(const std::string& text, bool bNarrow);
+    void buildLowerOptions();
+    void buildPrefixIndex();
+    void buildTrigramIndex();
+    void invalidateSearchIndex();
+/**
+ * @brief Drop the ID to index hash so it is rebuilt on next use. Call after reordering or
+ *        otherwise changing idList directly.
+ */
+    void invalidateIdIndex() { idIndex.clear(); bIdIndexValid = false; };
 /**
  * @brief This is the pure virtual which must be implemented by any class that utilizes
  *        lvppOptions. It is called by the 'set' functions to do the actual setting.
@@ -658,6 +975,25 @@ protected:
     std::vector<std::string> options;   ///< The vector of options kept locally.
     std::vector<uint64_t> idList;       ///< The vector of associated ID values (if used)
     const char* getNewlineSepOptions(); ///< Packs all the option strings into a single newline separated pointer.
+    std::unordered_map<uint64_t, uint32_t> idIndex;    ///< ID -> index into idList for setSelectedID().
+    bool bIdIndexValid=false;           ///< idIndex matches idList.
+    uint16_t bulkDepth=0;               ///< Nesting of beginOptionsUpdate().
+    uint16_t windowRows=0;              ///< Rows given to LVGL in virtual mode. 0 when not virtual.
+    uint32_t windowStart=0;             ///< Index of the first option in the window. Always 0 when not virtual.
+    uint32_t sourceCount=0;             ///< See setOptionSource().
+    lvppOptionSource source;            ///< See setOptionSource().
+    bool bFilterActive=false;           ///< setFilter() in effect.
+    bool bFilterValid=false;            ///< filtered matches the current options.
+    lvppFilterMode filterMode=LVPP_FILTER_PREFIX;
+    std::string filterText;             ///< Lower cased filter text.
+    std::vector<uint32_t> filtered;     ///< Indexes of the matching options, ascending.
+    std::vector<std::string> lowerOptions;  ///< Lower cased copy of options for matching.
+    std::vector<uint32_t> prefixOrder;  ///< Option indexes sorted by lowerOptions - the prefix index.
+    std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams;  ///< Trigram -> ascending option indexes containing it.
+    bool bLowerValid=false;
+    bool bPrefixIndexValid=false;
+    bool bTrigramIndexValid=false;
+    bool bOptionsDirty=false;           ///< Options changed during a bulk edit.
 };
 
 
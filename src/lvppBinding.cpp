@@ -0,0 +1,126 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#include "lvppBinding.h"
+
+#include <algorithm>
+
+/** @file lvppBinding.cpp
+ * @brief Implementation of lvppObservable.
+ */
+
+std::vector<lvppObservable*> lvppObservable::dirtyList;
+lv_timer_t* lvppObservable::pRefreshTimer = nullptr;
+
+lvppObservable::~lvppObservable() {
+    while (!bindings.empty())
+        unbind(bindings.back().pWidget);
+
+    if (bDirty) {
+        dirtyList.erase(std::remove(dirtyList.begin(), dirtyList.end(), this), dirtyList.end());
+    }
+}
+
+void lvppObservable::set(int16_t v) {
+    if (v == value)
+        return;
+
+    value = v;
+    markDirty();
+}
+
+void lvppObservable::bind(lvppBaseWithValue* pWidget, bool bTwoWay) {
+    binding b;
+
+    assert(pWidget);
+    b.pWidget = pWidget;
+    b.conn = 0;
+    if (bTwoWay) {
+        b.conn = pWidget->setCallbackOnValueChanged([this, pWidget]() { set(pWidget->getValue()); });
+    }
+    bindings.push_back(b);
+    pWidget->boundObservables.push_back(this);
+
+    // New widget needs to pick up the current value.
+    markDirty();
+}
+
+void lvppObservable::unbind(lvppBaseWithValue* pWidget) {
+    for (auto it = bindings.begin(); it != bindings.end(); ++it) {
+        if (it->pWidget == pWidget) {
+            if (it->conn)
+                pWidget->disconnect(it->conn);
+            bindings.erase(it);
+
+            auto& obs = pWidget->boundObservables;
+            auto found = std::find(obs.begin(), obs.end(), this);
+            if (found != obs.end())
+                obs.erase(found);
+            return;
+        }
+    }
+}
+
+void lvppObservable::markDirty() {
+    if (bDirty || bindings.empty())
+        return;
+
+    bDirty = true;
+    dirtyList.push_back(this);
+
+    if (!pRefreshTimer) {
+        pRefreshTimer = lv_timer_create(&lvppObservable::refreshTimerCb, LVPP_BINDING_REFRESH_MS, nullptr);
+    }
+    lv_timer_resume(pRefreshTimer);
+    lv_timer_ready(pRefreshTimer);
+}
+
+void lvppObservable::push() {
+    for (auto& b: bindings) {
+        // Skip widgets already showing the value - this is also what stops two-way echo.
+        if (b.pWidget->getValue() != value)
+            b.pWidget->setValue(value);
+    }
+}
+
+void lvppObservable::refresh() {
+    // Two-way bindings may dirty further observables while we push. Those get appended
+    // and handled in this same pass. clear() keeps the capacity so steady state won't allocate.
+    for (size_t i=0; i<dirtyList.size(); i++) {
+        lvppObservable* pObs = dirtyList[i];
+        pObs->bDirty = false;
+        pObs->push();
+    }
+    dirtyList.clear();
+
+    if (pRefreshTimer)
+        lv_timer_pause(pRefreshTimer);
+}
+
+void lvppObservable::refreshTimerCb(lv_timer_t* pTimer) {
+    refresh();
+}
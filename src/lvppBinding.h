@@ -0,0 +1,122 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#ifndef _LVPPBINDING_H
+#define _LVPPBINDING_H
+
+#include "lvppBase.h"
+
+#include <vector>
+
+/** @file lvppBinding.h
+ * @brief Observable model values which can be bound to lvppBaseWithValue widgets.
+ */
+
+/**
+ * @brief Period of the LVGL timer which pushes changed observables to their widgets. The timer
+ *        is paused while nothing is pending and is made ready as soon as something changes.
+ *        Can be overridden in platform.ini...build_flags with -D LVPP_BINDING_REFRESH_MS=n
+ */
+#ifndef LVPP_BINDING_REFRESH_MS
+#define LVPP_BINDING_REFRESH_MS 10
+#endif
+
+/**
+ * @brief A model value which lvppBar, lvppSlider, lvppArc (any lvppBaseWithValue) can bind to.
+ * 
+ * Instead of calling setValue() on every widget every loop, keep the value in an lvppObservable
+ * and bind() the widgets to it once. Setting the observable to a value it already holds costs
+ * nothing. Setting a new value only marks the observable as dirty - the widgets are updated
+ * together from an LVGL timer on the next lv_timer_handler() pass (or immediately via refresh()).
+ * Only observables which actually changed are visited, so the work is proportional to the
+ * changed bindings and not to the number of widgets on screen.
+ * 
+ * A two-way binding also feeds user changes on the widget (e.g. dragging a slider) back into
+ * the observable, which in turn updates every other widget bound to it.
+ * 
+ *     lvppObservable speed(0);
+ *     speed.bind(pSpeedBar);
+ *     speed.bind(pSpeedSlider, true);     // Two-way
+ *     ...
+ *     speed = newSpeedFromSensor;         // Widgets follow on the next refresh
+ * 
+ * _Note: Like LVGL itself this is not thread safe. Call set() while holding your LVGL lock.
+ *        A widget which is deleted (including by a lazy lvppScreen unloading) unbinds itself._
+ */
+class lvppObservable {
+public:
+    lvppObservable(int16_t initial=0) : value(initial) { };
+    ~lvppObservable();
+    lvppObservable(const lvppObservable&) = delete;
+    lvppObservable& operator=(const lvppObservable&) = delete;
+/**
+ * @brief Set a new model value. Bound widgets are updated on the next refresh if it changed.
+ * 
+ * @param v The new value.
+ */
+    void set(int16_t v);
+    int16_t get() const { return value; };
+    lvppObservable& operator=(int16_t v) { set(v); return *this; };
+    operator int16_t() const { return value; };
+/**
+ * @brief Bind a widget to this value. The widget takes on the current value at the next refresh.
+ * 
+ * @param pWidget The widget to keep in sync.
+ * @param bTwoWay When true, value changes made on the widget are written back into the observable.
+ */
+    void bind(lvppBaseWithValue* pWidget, bool bTwoWay=false);
+/**
+ * @brief Remove a widget's binding (and its write-back listener for two-way bindings).
+ * 
+ * @param pWidget The widget previously given to bind().
+ */
+    void unbind(lvppBaseWithValue* pWidget);
+/**
+ * @brief Push all pending changes to their widgets right now rather than waiting for the timer.
+ * 
+ */
+    static void refresh();
+/**
+ * @brief Number of observables with changes that have not been pushed to widgets yet.
+ */
+    static uint32_t getPendingCount() { return (uint32_t)dirtyList.size(); };
+protected:
+    struct binding {
+        lvppBaseWithValue* pWidget;
+        lvppConnection conn;        ///< Write-back listener on the widget for two-way bindings. 0 otherwise.
+    };
+    void markDirty();
+    void push();
+    static void refreshTimerCb(lv_timer_t* pTimer);
+    int16_t value;
+    bool bDirty = false;
+    std::vector<binding> bindings;
+    static std::vector<lvppObservable*> dirtyList;  ///< Observables changed since the last refresh.
+    static lv_timer_t* pRefreshTimer;               ///< Created on first use. Paused while nothing is pending.
+};
+
+#endif
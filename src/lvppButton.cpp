@@ -35,9 +35,8 @@ lvppButton::lvppButton(const char* fName, const char* pText, lv_obj_t* parent) :
     objParent = parent ? parent : lv_scr_act();
     createObj(lv_btn_create(objParent));
 
-    lv_style_set_pad_all(&style_obj, 5);
-//    lv_style_set_bg_color(&style_obj, lv_color_hex(0xf1f1f1));  // lv_color_hex(0xeeeeee));
-    lv_obj_add_style(obj, &style_obj, 0);
+    styleProps.setPadAll(5);
+    applySharedStyle();
 
     if (pText) {
         setText(pText);
@@ -50,8 +49,8 @@ lvppCycleButton::lvppCycleButton(const char* fName, lv_obj_t* parent) : lvppButt
 }
 
 void lvppCycleButton::clearOptions(void) {
-    options.clear();
     currentIndex = 0;
+    lvppOptions::clearOptions();
 }
 
 void lvppCycleButton::setOptions(const char* pText) {
@@ -117,7 +116,8 @@ lvppFullImageToggleButton::lvppFullImageToggleButton(const char* fName, lv_img_d
 }
 
 lvppFullImageToggleButton::~lvppFullImageToggleButton() {
-    if (pImage) {
+    // pImage is a child of obj. If LVGL already deleted obj, pImage went with it.
+    if (pImage && obj) {
         lv_obj_del(pImage);
         pImage = nullptr;
     }
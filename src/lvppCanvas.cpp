@@ -164,6 +164,7 @@ void lvppCanvasIndexed::setbgColor(lv_color_t bgColor) {
 }
 
 void lvppCanvasIndexed::setbgColorByIndex(lv_color_t bgColorIndex) {
+    LVPP_TRACE_SCOPE("canvas.fill");
     if (bgColorIndex.full>=colorIndexesUsed) {
         LV_LOG_WARN("setbgColorByIndex: index out of palette range.");
         return;
@@ -250,6 +251,7 @@ void lvppCanvasIndexed::drawRectWithoutFill(lv_coord_t x1, lv_coord_t y1, lv_coo
 
 void lvppCanvasIndexed::drawRectWithoutFillByIndex(lv_coord_t x1, lv_coord_t y1, lv_coord_t w, lv_coord_t h, 
         lv_color_t borderColorInd) {
+    LVPP_TRACE_SCOPE("canvas.drawRectWithoutFill");
     if (borderColorInd.full>=colorIndexesUsed) {
         LV_LOG_WARN("drawRectWithoutFillByIndex: index out of palette range.");
         return;
@@ -283,6 +285,7 @@ void lvppCanvasIndexed::drawRectWithFill(lv_coord_t x1, lv_coord_t y1, lv_coord_
 
 void lvppCanvasIndexed::drawRectWithFillByIndex(lv_coord_t x1, lv_coord_t y1, lv_coord_t w, lv_coord_t h, 
         lv_color_t borderColorInd, lv_color_t fillColorInd) {
+    LVPP_TRACE_SCOPE("canvas.drawRectWithFill");
     if (borderColorInd.full>=colorIndexesUsed) {
         LV_LOG_WARN("drawRectWithFillByIndex: border index out of palette range.");
         return;
@@ -402,6 +405,7 @@ lvppCanvasFullColor::~lvppCanvasFullColor() {
 }
 
 void lvppCanvasFullColor::setbgColor(lv_color_t bgColor) {
+    LVPP_TRACE_SCOPE("canvas.fill");
     lv_canvas_fill_bg(obj, bgColor, LV_OPA_COVER);
 }
 
@@ -411,6 +415,7 @@ void lvppCanvasFullColor::drawPixel(lv_coord_t x, lv_coord_t y, lv_color_t color
 
 void lvppCanvasFullColor::drawRect(lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h, 
         lv_coord_t borderThickness, lv_color_t borderColor, lv_color_t fillColor,  uint16_t radius, lv_opa_t opa) {
+    LVPP_TRACE_SCOPE("canvas.drawRect");
 
     if (!pDscRect) {
         pDscRect = new lv_draw_rect_dsc_t;
@@ -430,6 +435,7 @@ void lvppCanvasFullColor::drawRect(lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_
 }
 
 void lvppCanvasFullColor::drawLine(lv_coord_t x1, lv_coord_t y1, lv_coord_t x2, lv_coord_t y2, lv_coord_t width, lv_color_t color) {
+    LVPP_TRACE_SCOPE("canvas.drawLine");
 
     if (!pDscLine) {
         pDscLine = new lv_draw_line_dsc_t;
@@ -448,6 +454,7 @@ void lvppCanvasFullColor::drawLine(lv_coord_t x1, lv_coord_t y1, lv_coord_t x2,
 }
 
 void lvppCanvasFullColor::drawLabel(lv_coord_t x, lv_coord_t y, lv_coord_t maxW, lv_color_t color, const char* pText) {
+    LVPP_TRACE_SCOPE("canvas.drawLabel");
 
     if (!pText)
         return;
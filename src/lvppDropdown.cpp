@@ -43,6 +43,15 @@ void lvppDropdown::lvOptionSetter(const char* pOpts) {
     lv_dropdown_set_options(obj, pOpts);
 }
 
+bool lvppDropdown::lvOptionAppender(const char* pOpt) {
+    // pOpt is already in options. A dropdown made without options still shows LVGL's defaults.
+    if (lv_dropdown_get_option_cnt(obj) != options.size()-1)
+        return false;
+
+    lv_dropdown_add_option(obj, pOpt, LV_DROPDOWN_POS_LAST);
+    return true;
+}
+
 uint16_t lvppDropdown::lvOptionGetIndex() {
     return (uint16_t)lv_dropdown_get_selected(obj);
 }
@@ -58,18 +67,19 @@ void lvppDropdown::setOptions(const char* pOptions)
 {
     if (pOptions) {
         lvppOptions::setOptions(pOptions);
-        lv_dropdown_set_selected(obj, 0);
+        selectOption(0);
     }
 }
 
+// The base empties the list and updates the widget through the options path, so a clear inside
+// beginOptionsUpdate()/commitOptionsUpdate() is deferred like any other change.
 void lvppDropdown::clearOptions(void) {
     lvppOptions::clearOptions();
-    lv_dropdown_clear_options(obj);
 }
 
 void lvppDropdown::setOptions(std::vector<std::string> &options) {
     lvppOptions::setOptions(options);
-    lv_dropdown_set_selected(obj, 0);
+    selectOption(0);
 }
 
 // LV_DIR_BOTTOM, LV_DIR_TOP, LV_DIR_LEFT, LV_DIR_RIGHT
@@ -78,11 +88,19 @@ void lvppDropdown::setDropdownDirection(lv_dir_t dropDirection) {
 }
 
 void lvppDropdown::setSelectedIndex(uint16_t curInd) {
-    if (curInd < lv_dropdown_get_option_cnt(obj)) {
+    if (isVirtual() || isFiltered()) {
+        if (!selectOption(curInd))
+            return;
+    }
+    else if (curInd < lv_dropdown_get_option_cnt(obj)) {
         lv_dropdown_set_selected(obj, curInd);
-        internalOnValueChanged();
-        onValueChanged();
     }
+    else {
+        return;
+    }
+
+    internalOnValueChanged();
+    onValueChanged();
 }
 
 //////////////
@@ -114,27 +132,35 @@ void lvppRoller::setOptions(const char* pOptions)
 {
     if (pOptions) {
         lvppOptions::setOptions(pOptions);
-        lv_roller_set_selected(obj, 0, LV_ANIM_ON);
+        selectOption(0);
     }
     else {
         clearOptions();
     }
 }
 
+// See lvppDropdown::clearOptions() - the base updates the widget and honours bulk edits.
 void lvppRoller::clearOptions(void) {
     lvppOptions::clearOptions();
-    lv_roller_set_options(obj, "", LV_ROLLER_MODE_NORMAL);
 }
 
 void lvppRoller::setOptions(std::vector<std::string> &options) {
     lvppOptions::setOptions(options);
-    lv_roller_set_selected(obj, 0, LV_ANIM_ON);
+    selectOption(0);
 }
 
 void lvppRoller::setSelectedIndex(uint16_t curInd) {
-    if (curInd < lv_roller_get_option_cnt(obj)) {
+    if (isVirtual() || isFiltered()) {
+        if (!selectOption(curInd))
+            return;
+    }
+    else if (curInd < lv_roller_get_option_cnt(obj)) {
         lv_roller_set_selected(obj, curInd, LV_ANIM_ON);
-        internalOnValueChanged();
-        onValueChanged();
     }
+    else {
+        return;
+    }
+
+    internalOnValueChanged();
+    onValueChanged();
 }
@@ -36,13 +36,31 @@ lvppKeyboard::lvppKeyboard(const char* fName, lv_obj_t* parent) : lvppBase(fName
     obj = nullptr;
 }
 
-void lvppKeyboard::enableKeyboard(bool bEnable) {
+lvppKeyboard::~lvppKeyboard() {
+    cancelIdleTimer();
+}
+
+void lvppKeyboard::enableKeyboard(bool bEnable, lv_obj_t* pScreen) {
+    if (!pScreen)
+        pScreen = lv_scr_act();
+
     if (bEnable && !obj) {
-       createObj(lv_keyboard_create(lv_scr_act()));
-//        createObj(lv_keyboard_create(objParent));
+        createObj(lv_keyboard_create(pScreen));
+        cancelIdleTimer();
+    }
+    else if (bEnable) {
+        // Persistent keyboard - just move it to the screen in use and show it.
+        if (lv_obj_get_parent(obj) != pScreen)
+            lv_obj_set_parent(obj, pScreen);
+        lv_obj_clear_flag(obj, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_move_foreground(obj);
     }
     else {
-        if (obj) {
+        if (obj && bPersistent) {
+            lv_keyboard_set_textarea(obj, NULL);
+            lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+        }
+        else if (obj) {
             lv_obj_remove_event_cb(obj, NULL);
             lv_obj_del(obj);
             obj = nullptr;
@@ -50,6 +68,47 @@ void lvppKeyboard::enableKeyboard(bool bEnable) {
     }
 }
 
+void lvppKeyboard::setPersistent(bool bPersist) {
+    bPersistent = bPersist;
+
+    if (!bPersistent && obj && lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN))
+        enableKeyboard(false);
+}
+
+void lvppKeyboard::precreate(lv_obj_t* pScreen) {
+    bPersistent = true;
+    if (obj)
+        return;
+
+    enableKeyboard(true, pScreen);
+    enableKeyboard(false);
+}
+
+void lvppKeyboard::precreateWhenIdle(uint32_t idleMs) {
+    bPersistent = true;
+    if (obj || pIdleTimer)
+        return;
+
+    precreateIdleMs = idleMs;
+    pIdleTimer = lv_timer_create(idleTimerCb, idleMs, this);
+}
+
+void lvppKeyboard::idleTimerCb(lv_timer_t* pTimer) {
+    lvppKeyboard* pThis = (lvppKeyboard*)pTimer->user_data;
+
+    if (lv_disp_get_inactive_time(NULL) >= pThis->precreateIdleMs) {
+        pThis->cancelIdleTimer();
+        pThis->precreate();
+    }
+}
+
+void lvppKeyboard::cancelIdleTimer() {
+    if (pIdleTimer) {
+        lv_timer_del(pIdleTimer);
+        pIdleTimer = nullptr;
+    }
+}
+
 void lvppKeyboard::eventHandler(lv_event_t* event) {
     lv_obj_t *ta;
     lv_event_code_t code = lv_event_get_code(event);
@@ -69,6 +128,7 @@ void lvppKeyboard::eventHandler(lv_event_t* event) {
                 }
             }
             enableKeyboard(false);
+            break;
         default:
             break;
     }
@@ -49,8 +49,9 @@ lvppLabel::lvppLabel(const char* fName, const char* pText, lv_obj_t* parent) : l
 }
 
 void lvppLabel::setText(const char* pText) {
+    LVPP_TRACE_SCOPE("setText");
     if (pText) {
-        lv_label_set_text(obj, pText);
+        setLabelTextIfChanged(obj, pText);
     }
 }
 
@@ -58,6 +59,6 @@ void lvppLabel::setText(const char* pText) {
  * 
 */
 void lvppLabel::setTextColor(lv_color_t newColor) {
-    lv_style_set_text_color(&style_obj, newColor);
-    lv_obj_add_style(obj, &style_obj, 0);
+    styleProps.setTextColor(newColor);
+    applySharedStyle();
 }
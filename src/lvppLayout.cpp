@@ -0,0 +1,284 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#include "lvppLayout.h"
+
+/**
+ * @file lvppLayout.cpp
+ * @brief Implementation of the binary layout loader.
+ */
+
+// Unaligned little-endian reads. Blobs are often placed in flash with no alignment guarantee.
+static inline uint16_t rd16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline int16_t rdi16(const uint8_t* p) { return (int16_t)rd16(p); }
+static inline uint32_t rd32(const uint8_t* p) { return (uint32_t)rd16(p) | ((uint32_t)rd16(p+2) << 16); }
+
+bool lvppLayout::validate(const uint8_t* pBlob, size_t len) {
+    if (!pBlob || len < LVPP_LAYOUT_HEADER_SIZE || memcmp(pBlob, "LVPL", 4)) {
+        LV_LOG_WARN("lvppLayout: Not a layout blob.");
+        return false;
+    }
+
+    if (pBlob[4] != LVPP_LAYOUT_VERSION) {
+        LV_LOG_WARN("lvppLayout: Unsupported layout version %d.", pBlob[4]);
+        return false;
+    }
+
+    uint16_t count = rd16(pBlob+6);
+    uint32_t recOffset = rd32(pBlob+8);
+    uint32_t strOffset = rd32(pBlob+12);
+
+    // The string table runs to the end of the blob and must end in a NUL so no string can overrun.
+    if (strOffset >= len || strOffset < recOffset || pBlob[len-1] != 0) {
+        LV_LOG_WARN("lvppLayout: Bad string table.");
+        return false;
+    }
+    size_t strSize = len - strOffset;
+
+    uint32_t off = recOffset;
+    for (uint16_t i=0; i<count; i++) {
+        if (off + LVPP_LAYOUT_RECORD_SIZE > strOffset) {
+            LV_LOG_WARN("lvppLayout: Record %d out of bounds.", i);
+            return false;
+        }
+
+        const uint8_t* pRec = pBlob + off;
+        uint16_t recSize = rd16(pRec+2);
+        if (recSize < LVPP_LAYOUT_RECORD_SIZE || off + recSize > strOffset
+            || rd16(pRec+4) >= strSize
+            || (rd16(pRec+6) != LVPP_LAYOUT_NO_STRING && rd16(pRec+6) >= strSize)) {
+            LV_LOG_WARN("lvppLayout: Record %d is malformed.", i);
+            return false;
+        }
+
+        // Properties must exactly fill the rest of the record.
+        uint16_t p = LVPP_LAYOUT_RECORD_SIZE;
+        while (p < recSize) {
+            if (p + 2 > recSize || p + 2 + pRec[p+1] > recSize) {
+                LV_LOG_WARN("lvppLayout: Record %d has a malformed property.", i);
+                return false;
+            }
+
+            // String payloads always lead with the u16 string offset.
+            uint8_t tag = pRec[p];
+            if ((tag==LVPP_PROP_OPTIONS || tag==LVPP_PROP_VALUE_FORMAT || tag==LVPP_PROP_ADJ_TEXT)
+                && (pRec[p+1] < 2 || rd16(pRec+p+2) >= strSize)) {
+                LV_LOG_WARN("lvppLayout: Record %d has a bad string property.", i);
+                return false;
+            }
+            p += 2 + pRec[p+1];
+        }
+
+        off += recSize;
+    }
+
+    return true;
+}
+
+int16_t lvppLayout::load(lvppScreen* pScreen, const uint8_t* pBlob, size_t len,
+                         lvppObservable** ppObservables, uint8_t observableCount) {
+    assert(pScreen);
+
+    if (!validate(pBlob, len))
+        return -1;
+
+    uint16_t count = rd16(pBlob+6);
+    const char* pStrings = (const char*)pBlob + rd32(pBlob+12);
+    const uint8_t* pRec = pBlob + rd32(pBlob+8);
+    int16_t created = 0;
+
+    for (uint16_t i=0; i<count; i++) {
+        uint8_t type = pRec[0];
+        uint16_t recSize = rd16(pRec+2);
+        uint16_t textOff = rd16(pRec+6);
+
+        lvppBase* pObj = createWidget(pScreen, type, pStrings + rd16(pRec+4),
+                                      textOff == LVPP_LAYOUT_NO_STRING ? nullptr : pStrings + textOff);
+        if (pObj) {
+            lv_coord_t w = rdi16(pRec+12);
+            lv_coord_t h = rdi16(pRec+14);
+            // 0 keeps the widget's default for that dimension alone.
+            if (w && h)
+                pObj->setSize(w, h);
+            else if (w)
+                lv_obj_set_width(pObj->getObj(), w);
+            else if (h)
+                lv_obj_set_height(pObj->getObj(), h);
+            pObj->align((lv_align_t)pRec[1], rdi16(pRec+8), rdi16(pRec+10));
+
+            for (uint16_t p = LVPP_LAYOUT_RECORD_SIZE; p < recSize; p += 2 + pRec[p+1])
+                applyProp(pObj, type, pRec[p], pRec+p+2, pRec[p+1], pStrings, ppObservables, observableCount);
+
+            created++;
+        }
+        else {
+            LV_LOG_WARN("lvppLayout: Record %d has unknown widget type %d or could not be created.", i, type);
+        }
+
+        pRec += recSize;
+    }
+
+    return created;
+}
+
+lvppScreenBuilder lvppLayout::builder(const uint8_t* pBlob, size_t len,
+                                      lvppObservable** ppObservables, uint8_t observableCount) {
+    return [=](lvppScreen* pScreen) { load(pScreen, pBlob, len, ppObservables, observableCount); };
+}
+
+lvppBase* lvppLayout::createWidget(lvppScreen* pScreen, uint8_t type, const char* pName, const char* pText) {
+    lvppBase* pObj = nullptr;
+    // Create straight under the target screen. Creating on lv_scr_act() and re-parenting in
+    // addObject() would invalidate and relayout the visible screen on every prefetch slice.
+    lv_obj_t* pParent = pScreen->getScreen();
+
+    switch(type) {
+        case LVPP_LAYOUT_BUTTON:
+            pObj = pScreen->createObject<lvppButton>(pName, pText, pParent);
+            break;
+        case LVPP_LAYOUT_LABEL:
+            pObj = pScreen->createObject<lvppLabel>(pName, pText, pParent);
+            break;
+        case LVPP_LAYOUT_TEXTAREA:
+            pObj = pScreen->createObject<lvppTextarea>(pName, pText, pParent);
+            break;
+        case LVPP_LAYOUT_BAR:
+            pObj = pScreen->createObject<lvppBar>(pName, pParent);
+            break;
+        case LVPP_LAYOUT_SLIDER:
+            pObj = pScreen->createObject<lvppSlider>(pName, pParent);
+            break;
+        case LVPP_LAYOUT_ARC:
+            pObj = pScreen->createObject<lvppArc>(pName, pParent);
+            break;
+        case LVPP_LAYOUT_SWITCH:
+            pObj = pScreen->createObject<lvppSwitch>(pName, pParent);
+            break;
+        case LVPP_LAYOUT_DROPDOWN:
+            pObj = pScreen->createObject<lvppDropdown>(pName, nullptr, pParent);
+            break;
+        case LVPP_LAYOUT_ROLLER:
+            pObj = pScreen->createObject<lvppRoller>(pName, nullptr, pParent);
+            break;
+        default:
+            break;
+    }
+
+    // Widgets other than the text ones carry their text on their own label.
+    if (pObj && pText && (type==LVPP_LAYOUT_BAR || type==LVPP_LAYOUT_SLIDER || type==LVPP_LAYOUT_ARC
+                          || type==LVPP_LAYOUT_SWITCH))
+        pObj->setText(pText);
+
+    return pObj;
+}
+
+void lvppLayout::applyProp(lvppBase* pObj, uint8_t type, uint8_t tag, const uint8_t* p, uint8_t len,
+                           const char* pStrings, lvppObservable** ppObservables, uint8_t observableCount) {
+    bool bHasValue = (type==LVPP_LAYOUT_BAR || type==LVPP_LAYOUT_SLIDER || type==LVPP_LAYOUT_ARC);
+    lvppBaseWithValue* pValObj = bHasValue ? (lvppBaseWithValue*)pObj : nullptr;
+    lvppOptions* pOptions = nullptr;
+
+    if (type==LVPP_LAYOUT_DROPDOWN)
+        pOptions = (lvppDropdown*)pObj;
+    else if (type==LVPP_LAYOUT_ROLLER)
+        pOptions = (lvppRoller*)pObj;
+
+    switch(tag) {
+        case LVPP_PROP_FONT_SIZE:
+            if (len >= 1)
+                pObj->setFontSize(p[0]);
+            return;
+        case LVPP_PROP_TEXT_COLOR:
+            if (len >= 4)
+                pObj->setTextColor(lv_color_hex(rd32(p)));
+            return;
+        case LVPP_PROP_BG_COLOR:
+            if (len >= 4)
+                pObj->setBGColor(lv_color_hex(rd32(p)));
+            return;
+        case LVPP_PROP_RANGE:
+            if (len < 4)
+                break;
+            if (type==LVPP_LAYOUT_BAR)
+                ((lvppBar*)pObj)->setRange(rdi16(p), rdi16(p+2));
+            else if (type==LVPP_LAYOUT_SLIDER)
+                ((lvppSlider*)pObj)->setRange(rdi16(p), rdi16(p+2));
+            else if (type==LVPP_LAYOUT_ARC)
+                ((lvppArc*)pObj)->setRange(rdi16(p), rdi16(p+2));
+            else
+                break;
+            return;
+        case LVPP_PROP_VALUE:
+            if (len < 2)
+                break;
+            if (pValObj)
+                pValObj->setValue(rdi16(p), false);
+            else if (type==LVPP_LAYOUT_SWITCH)
+                ((lvppSwitch*)pObj)->setCheckedState(rdi16(p) != 0);
+            else if (type==LVPP_LAYOUT_DROPDOWN)
+                ((lvppDropdown*)pObj)->setSelectedIndex(rd16(p));
+            else if (type==LVPP_LAYOUT_ROLLER)
+                ((lvppRoller*)pObj)->setSelectedIndex(rd16(p));
+            else
+                break;
+            return;
+        case LVPP_PROP_OPTIONS:
+            if (!pOptions)
+                break;
+            pOptions->setOptions(pStrings + rd16(p));
+            return;
+        case LVPP_PROP_VALUE_LABEL:
+            if (!pValObj || len < 5)
+                break;
+            pValObj->enableValueLabel(rdi16(p+1), rdi16(p+3), (lv_align_t)p[0]);
+            return;
+        case LVPP_PROP_VALUE_FORMAT:
+            if (!pValObj)
+                break;
+            pValObj->setValueLabelFormat(pStrings + rd16(p), len >= 3 ? p[2] : 0);
+            return;
+        case LVPP_PROP_ADJ_TEXT:
+            if (len < 6)
+                break;
+            pObj->setAdjText(pStrings + rd16(p), rdi16(p+2), rdi16(p+4));
+            return;
+        case LVPP_PROP_BIND:
+            if (!pValObj || len < 2)
+                break;
+            if (p[0] >= observableCount || !ppObservables || !ppObservables[p[0]]) {
+                LV_LOG_WARN("lvppLayout: %s binds to missing observable %d.", pObj->getFriendlyName().c_str(), p[0]);
+                return;
+            }
+            ppObservables[p[0]]->bind(pValObj, p[1] != 0);
+            return;
+        default:
+            // Newer property - skip.
+            return;
+    }
+
+    LV_LOG_WARN("lvppLayout: Property %d does not apply to %s.", tag, pObj->getFriendlyName().c_str());
+}
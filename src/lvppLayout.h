@@ -0,0 +1,138 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#ifndef _LVPPLAYOUT_H
+#define _LVPPLAYOUT_H
+
+#ifdef LV_LVGL_H_INCLUDE_SIMPLE
+#include "lvgl.h"
+#else
+#include "lvgl/lvgl.h"
+#endif
+
+#include "lvpp.h"
+
+/** @file lvppLayout.h
+ * @brief Loader for binary screen layouts - widgets, geometry, styles, options and bindings
+ *        described in a compact blob rather than in code.
+ * 
+ * Blobs are produced on the host from a JSON description by support/lvpp_layout.py, which can also
+ * emit a C array to compile into flash. All multi-byte fields are little-endian and may be unaligned.
+ * 
+ * Layout of a blob:
+ * - Header (LVPP_LAYOUT_HEADER_SIZE bytes): magic "LVPL", u8 version, u8 reserved, u16 widget count,
+ *   u32 offset of the first widget record, u32 offset of the string table.
+ * - Widget records, one after another (LVPP_LAYOUT_RECORD_SIZE bytes plus properties):
+ *   u8 type (lvppLayoutType), u8 alignment (lv_align_t), u16 record size including properties,
+ *   u16 name, u16 text, i16 x, i16 y, i16 width, i16 height.
+ *   Strings are offsets into the string table, LVPP_LAYOUT_NO_STRING for none. A width or height
+ *   of 0 leaves the widget's default for that dimension; the other is still applied.
+ * - Properties follow each record until the record size is used up: u8 tag (lvppLayoutProp),
+ *   u8 payload length, payload. Unknown tags are skipped.
+ * - String table: NUL terminated strings.
+ */
+
+#define LVPP_LAYOUT_VERSION 1
+#define LVPP_LAYOUT_HEADER_SIZE 16
+#define LVPP_LAYOUT_RECORD_SIZE 16
+#define LVPP_LAYOUT_NO_STRING 0xFFFF
+
+/**
+ * @brief Widget types in a layout record.
+ */
+enum lvppLayoutType : uint8_t {
+    LVPP_LAYOUT_BUTTON=1,
+    LVPP_LAYOUT_LABEL,
+    LVPP_LAYOUT_TEXTAREA,
+    LVPP_LAYOUT_BAR,
+    LVPP_LAYOUT_SLIDER,
+    LVPP_LAYOUT_ARC,
+    LVPP_LAYOUT_SWITCH,
+    LVPP_LAYOUT_DROPDOWN,
+    LVPP_LAYOUT_ROLLER,
+};
+
+/**
+ * @brief Property tags following a layout record, with their payloads.
+ */
+enum lvppLayoutProp : uint8_t {
+    LVPP_PROP_FONT_SIZE=1,      ///< u8 points - setFontSize()
+    LVPP_PROP_TEXT_COLOR,       ///< u32 0xRRGGBB - setTextColor()
+    LVPP_PROP_BG_COLOR,         ///< u32 0xRRGGBB - setBGColor()
+    LVPP_PROP_RANGE,            ///< i16 min, i16 max - setRange() of bar, slider, arc
+    LVPP_PROP_VALUE,            ///< i16 - setValue(), selected index of dropdown/roller, switch state
+    LVPP_PROP_OPTIONS,          ///< u16 string of newline separated options - setOptions()
+    LVPP_PROP_VALUE_LABEL,      ///< u8 alignment, i16 x offset, i16 y offset - enableValueLabel()
+    LVPP_PROP_VALUE_FORMAT,     ///< u16 string, u8 fixed point decimals - setValueLabelFormat()
+    LVPP_PROP_ADJ_TEXT,         ///< u16 string, i16 x offset, i16 y offset - setAdjText()
+    LVPP_PROP_BIND,             ///< u8 observable index, u8 two way - lvppObservable::bind()
+};
+
+/**
+ * @class lvppLayout
+ * @brief Instantiates the widgets of an lvppScreen from a binary layout blob.
+ * 
+ * Widgets are created with lvppScreen::createObject() so their wrappers come from the screen's arena,
+ * and the blob is read in place - strings are used straight from it and nothing is parsed
+ * at runtime. The blob only needs to stay valid during load().
+ */
+class lvppLayout {
+public:
+/**
+ * @brief Check the header and the bounds of every record of a blob.
+ * 
+ * @param pBlob The layout blob.
+ * @param len Length of the blob in bytes.
+ * @return true if the blob can be loaded.
+ */
+    static bool validate(const uint8_t* pBlob, size_t len);
+/**
+ * @brief Create the widgets described by pBlob in pScreen.
+ * 
+ * @param pScreen The screen to populate.
+ * @param pBlob The layout blob.
+ * @param len Length of the blob in bytes.
+ * @param ppObservables Observables referred to by index from LVPP_PROP_BIND properties. Optional.
+ * @param observableCount Number of entries in ppObservables.
+ * @return int16_t Number of widgets created, or -1 if the blob is invalid.
+ */
+    static int16_t load(lvppScreen* pScreen, const uint8_t* pBlob, size_t len,
+                        lvppObservable** ppObservables=nullptr, uint8_t observableCount=0);
+/**
+ * @brief A builder for a lazy screen which loads the blob on demand, e.g.
+ *        `lvppScreen settings(lvppLayout::builder(settings_layout, sizeof(settings_layout)));`
+ *        The blob must then stay valid for the life of the screen.
+ */
+    static lvppScreenBuilder builder(const uint8_t* pBlob, size_t len,
+                        lvppObservable** ppObservables=nullptr, uint8_t observableCount=0);
+protected:
+    static lvppBase* createWidget(lvppScreen* pScreen, uint8_t type, const char* pName, const char* pText);
+    static void applyProp(lvppBase* pObj, uint8_t type, uint8_t tag, const uint8_t* p, uint8_t len,
+                        const char* pStrings, lvppObservable** ppObservables, uint8_t observableCount);
+};
+
+#endif
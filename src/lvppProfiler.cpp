@@ -0,0 +1,265 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#include "lvppProfiler.h"
+
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#ifndef ESP_PLATFORM
+#include <chrono>
+#include <stdio.h>
+#else
+#include "Arduino.h"
+#endif
+
+/**
+ * @file lvppProfiler.cpp
+ * @brief Implementation of the frame-time profiler.
+ */
+
+lvppProfiler LVPPProfiler;
+lvppProfiler* lvppProfiler::pActive = nullptr;
+
+uint32_t lvppProfiler::nowUs() {
+#ifdef ESP_PLATFORM
+    return micros();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+bool lvppProfiler::begin(lv_disp_t* _pDisp) {
+    if (!_pDisp)
+        _pDisp = lv_disp_get_default();
+    if (!_pDisp || pDisp || pActive) {
+        LV_LOG_WARN("lvppProfiler: No display or a profiler is already running.");
+        return false;
+    }
+
+    lv_timer_t* pRefr = _lv_disp_get_refr_timer(_pDisp);
+    if (!pRefr)
+        return false;
+
+    pDisp = _pDisp;
+    pActive = this;
+
+    origRefrCb = pRefr->timer_cb;
+    pRefr->timer_cb = refrTimerCb;
+    origFlushCb = pDisp->driver->flush_cb;
+    pDisp->driver->flush_cb = flushCb;
+    origMonitorCb = pDisp->driver->monitor_cb;
+    pDisp->driver->monitor_cb = monitorCb;
+    return true;
+}
+
+void lvppProfiler::end() {
+    if (!pDisp)
+        return;
+
+    lv_timer_t* pRefr = _lv_disp_get_refr_timer(pDisp);
+    if (pRefr)
+        pRefr->timer_cb = origRefrCb;
+    pDisp->driver->flush_cb = origFlushCb;
+    pDisp->driver->monitor_cb = origMonitorCb;
+
+    pDisp = nullptr;
+    pActive = nullptr;
+    bFramePending = false;
+}
+
+void lvppProfiler::reset() {
+    nextFrame = 0;
+    totalFrames = 0;
+    bFramePending = false;
+}
+
+uint32_t lvppProfiler::timerHandler() {
+    uint32_t start = nowUs();
+    bInHandler = true;
+    uint32_t next = lv_timer_handler();
+    bInHandler = false;
+
+    if (bFramePending) {
+        current.timerUs = nowUs() - start;
+        commitFrame();
+    }
+    return next;
+}
+
+void lvppProfiler::refrTimerCb(lv_timer_t* pTimer) {
+    lvppProfiler* p = pActive;
+    if (!p) {
+        return;
+    }
+
+    p->flushAccumUs = 0;
+    p->bFramePending = false;
+    uint32_t start = nowUs();
+    p->origRefrCb(pTimer);
+    uint32_t refresh = nowUs() - start;
+
+    // monitorCb() flags the refresh as a frame only if something was drawn.
+    if (p->bFramePending) {
+        p->current.refreshUs = refresh;
+        p->current.flushUs = p->flushAccumUs;
+        p->current.renderUs = refresh > p->flushAccumUs ? refresh - p->flushAccumUs : 0;
+        p->current.timerUs = 0;
+        if (!p->bInHandler)
+            p->commitFrame();
+    }
+}
+
+void lvppProfiler::flushCb(lv_disp_drv_t* pDrv, const lv_area_t* pArea, lv_color_t* pColor) {
+    lvppProfiler* p = pActive;
+    uint32_t start = nowUs();
+    p->origFlushCb(pDrv, pArea, pColor);
+    p->flushAccumUs += nowUs() - start;
+}
+
+void lvppProfiler::monitorCb(lv_disp_drv_t* pDrv, uint32_t time, uint32_t px) {
+    lvppProfiler* p = pActive;
+    p->current.pixels = px;
+    p->bFramePending = true;
+    if (p->origMonitorCb)
+        p->origMonitorCb(pDrv, time, px);
+}
+
+void lvppProfiler::commitFrame() {
+    frames[nextFrame] = current;
+    nextFrame = (nextFrame + 1) % LVPP_PROFILE_FRAMES;
+    totalFrames++;
+    bFramePending = false;
+}
+
+uint32_t lvppProfiler::getFrameCount() {
+    return totalFrames < LVPP_PROFILE_FRAMES ? totalFrames : LVPP_PROFILE_FRAMES;
+}
+
+bool lvppProfiler::getFrame(uint32_t index, lvppFrameSample_t& sample) {
+    uint32_t count = getFrameCount();
+    if (index >= count)
+        return false;
+
+    sample = frames[(nextFrame + LVPP_PROFILE_FRAMES - count + index) % LVPP_PROFILE_FRAMES];
+    return true;
+}
+
+uint32_t lvppProfiler::phaseValue(const lvppFrameSample_t& s, lvppProfilePhase phase) {
+    switch(phase) {
+        case LVPP_PHASE_TIMER:      return s.timerUs;
+        case LVPP_PHASE_REFRESH:    return s.refreshUs;
+        case LVPP_PHASE_RENDER:     return s.renderUs;
+        case LVPP_PHASE_FLUSH:      return s.flushUs;
+    }
+    return 0;
+}
+
+uint32_t lvppProfiler::getPercentile(lvppProfilePhase phase, uint8_t pct) {
+    uint32_t count = getFrameCount();
+    if (!count)
+        return 0;
+    if (pct > 100)
+        pct = 100;
+
+    // Done only when reporting - a copy on the stack, the frames stay in arrival order.
+    uint32_t values[LVPP_PROFILE_FRAMES];
+    for (uint32_t i=0; i<count; i++)
+        values[i] = phaseValue(frames[i], phase);
+
+    uint32_t rank = (count - 1) * pct / 100;
+    std::nth_element(values, values + rank, values + count);
+    return values[rank];
+}
+
+void lvppProfiler::getHistogram(uint32_t* pCounts) {
+    static const uint32_t edgesUs[LVPP_PROFILE_BUCKETS-1] = { 1000, 2000, 4000, 8000, 16000, 33000, 66000 };
+    uint32_t count = getFrameCount();
+
+    std::fill(pCounts, pCounts + LVPP_PROFILE_BUCKETS, 0);
+    for (uint32_t i=0; i<count; i++) {
+        uint8_t b = std::upper_bound(edgesUs, edgesUs + LVPP_PROFILE_BUCKETS - 1, frames[i].refreshUs) - edgesUs;
+        pCounts[b]++;
+    }
+}
+
+void lvppProfiler::printReport() {
+    std::string s = getReport();
+#ifdef ESP_PLATFORM
+    Serial.println(s.c_str());
+#else
+    printf("%s\n", s.c_str());
+#endif
+}
+
+std::string lvppProfiler::getReport() {
+    static const char* phaseNames[] = { "timer", "refresh", "render", "flush" };
+    static const char* bucketNames[LVPP_PROFILE_BUCKETS] = { "<1ms", "<2ms", "<4ms", "<8ms", "<16ms", "<33ms", "<66ms", ">=66ms" };
+    constexpr int fWid = 10;
+    constexpr int tWid = fWid * 5 + 1;     // Fields are "|" + space + 8, then the closing "|"
+    std::stringstream rpt;
+    uint32_t count = getFrameCount();
+
+    uint64_t pixels = 0;
+    for (uint32_t i=0; i<count; i++)
+        pixels += frames[i].pixels;
+
+    rpt << "LVPP PROFILE (us): " << count << " frames";
+    if (count)
+        rpt << ", avg " << std::fixed << std::setprecision(1) << pixels / 1000.0 / count << " kpx/frame";
+    rpt << std::endl;
+    if (!count)
+        return rpt.str();
+
+    rpt << std::left;
+    rpt.fill('-');
+    rpt << std::setw(tWid) << '-' << std::endl;
+    rpt.fill(' ');
+    rpt << "| PHASE   | P50     | P90     | P99     | MAX     |" << std::endl;
+    rpt.fill('-');
+    rpt << std::setw(tWid) << '-' << std::endl;
+    rpt.fill(' ');
+    for (uint8_t ph=LVPP_PHASE_TIMER; ph<=LVPP_PHASE_FLUSH; ph++) {
+        rpt << "| " << std::setw(fWid-2) << phaseNames[ph];
+        rpt << "| " << std::setw(fWid-2) << getPercentile((lvppProfilePhase)ph, 50);
+        rpt << "| " << std::setw(fWid-2) << getPercentile((lvppProfilePhase)ph, 90);
+        rpt << "| " << std::setw(fWid-2) << getPercentile((lvppProfilePhase)ph, 99);
+        rpt << "| " << std::setw(fWid-2) << getPercentile((lvppProfilePhase)ph, 100) << "|" << std::endl;
+    }
+    rpt.fill('-');
+    rpt << std::setw(tWid) << '-' << std::endl;
+
+    uint32_t buckets[LVPP_PROFILE_BUCKETS];
+    getHistogram(buckets);
+    rpt << "refresh:";
+    for (uint8_t b=0; b<LVPP_PROFILE_BUCKETS; b++)
+        rpt << (b ? " | " : " ") << bucketNames[b] << " " << buckets[b];
+    rpt << std::endl;
+
+    return rpt.str();
+}
@@ -0,0 +1,182 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#ifndef _LVPPPROFILER_H
+#define _LVPPPROFILER_H
+
+#ifdef LV_LVGL_H_INCLUDE_SIMPLE
+#include "lvgl.h"
+#else
+#include "lvgl/lvgl.h"
+#endif
+
+#include <string>
+
+/** @file lvppProfiler.h
+ * @brief Per-frame timing of LVGL - timer handler, refresh, render and flush - kept in a small ring
+ *        and reported as percentiles and a histogram.
+ */
+
+/**
+ * @brief Number of frames kept by lvppProfiler. Can be overridden in platform.ini...build_flags with -D LVPP_PROFILE_FRAMES=n
+ */
+#ifndef LVPP_PROFILE_FRAMES
+#define LVPP_PROFILE_FRAMES 128
+#endif
+
+/**
+ * @brief Timings of one refreshed frame in microseconds.
+ */
+typedef struct lvppFrameSample {
+    uint32_t timerUs;       ///< The whole lv_timer_handler() pass which refreshed (0 unless lvppProfiler::timerHandler() is used).
+    uint32_t refreshUs;     ///< The display refresh: layout, style resolution, drawing and flushing.
+    uint32_t renderUs;      ///< refreshUs less flushUs.
+    uint32_t flushUs;       ///< Time spent in the display driver's flush_cb. Only the hand-off if the flush is asynchronous.
+    uint32_t pixels;        ///< Pixels rendered, as reported to monitor_cb.
+} lvppFrameSample_t;
+
+/**
+ * @brief Which phase of lvppFrameSample_t getPercentile() looks at.
+ */
+enum lvppProfilePhase : uint8_t {
+    LVPP_PHASE_TIMER,
+    LVPP_PHASE_REFRESH,
+    LVPP_PHASE_RENDER,
+    LVPP_PHASE_FLUSH,
+};
+
+/**
+ * @brief Frame-time profiler for one display.
+ * 
+ * begin() wraps the display's refresh timer, flush_cb and monitor_cb (the originals are still
+ * called, so a HAL's own hooks keep working). Every refresh that draws something becomes one
+ * lvppFrameSample_t in a fixed ring of LVPP_PROFILE_FRAMES entries - no allocation, a handful of
+ * timestamps per frame - so it can stay enabled in production builds.
+ * 
+ * LVGL 8 has no hooks between layout, style resolution and drawing, so those are all inside
+ * renderUs. To also time the rest of lv_timer_handler() (input, animations, user timers) call
+ * LVPPProfiler.timerHandler() in its place.
+ * 
+ * Reports follow espSystats - getReport() returns a std::string and printReport() prints it:
+ * 
+ *     LVPP PROFILE (us): 128 frames, avg 3.2 kpx/frame
+ *     ---------------------------------------------------
+ *     | PHASE   | P50     | P90     | P99     | MAX     |
+ *     ---------------------------------------------------
+ *     | timer   | 2210    | 4130    | 9050    | 9800    |
+ *     | refresh | 2050    | 3990    | 8870    | 9620    |
+ *     | render  | 1500    | 3020    | 6600    | 7150    |
+ *     | flush   | 550     | 970     | 2270    | 2470    |
+ *     ---------------------------------------------------
+ *     refresh: <1ms 12 | <2ms 40 | <4ms 60 | <8ms 12 | <16ms 4 | <33ms 0 | <66ms 0 | >=66ms 0
+ */
+class lvppProfiler {
+public:
+/**
+ * @brief Start profiling a display.
+ * 
+ * @param pDisp The display, or nullptr for the default display.
+ * @return false if there is no display or the profiler is already running.
+ */
+    bool begin(lv_disp_t* pDisp=nullptr);
+/**
+ * @brief Stop profiling and restore the display's callbacks. Samples are kept.
+ */
+    void end();
+    bool isRunning() { return pDisp != nullptr; };
+/**
+ * @brief Forget all samples.
+ */
+    void reset();
+/**
+ * @brief Drop-in replacement for lv_timer_handler() which also times the whole pass.
+ * 
+ * @return uint32_t What lv_timer_handler() returned - ms until the next timer is due.
+ */
+    uint32_t timerHandler();
+
+    uint32_t getFrameCount();   ///< Frames currently held - at most LVPP_PROFILE_FRAMES.
+    uint32_t getTotalFrames() { return totalFrames; };  ///< Frames seen since begin()/reset().
+/**
+ * @brief Get a held frame.
+ * 
+ * @param index 0 is the oldest frame held.
+ * @param sample Filled in with the frame's timings.
+ * @return false if index is out of range.
+ */
+    bool getFrame(uint32_t index, lvppFrameSample_t& sample);
+/**
+ * @brief Percentile of one phase over the held frames.
+ * 
+ * @param phase Which timing.
+ * @param pct 0-100. 50 is the median, 100 the maximum.
+ * @return uint32_t Microseconds, 0 if there are no frames.
+ */
+    uint32_t getPercentile(lvppProfilePhase phase, uint8_t pct);
+/**
+ * @brief Count the held frames into refresh time buckets of <1, <2, <4, <8, <16, <33, <66 and >=66 ms.
+ * 
+ * @param pCounts Array of LVPP_PROFILE_BUCKETS counts to fill.
+ */
+    void getHistogram(uint32_t* pCounts);
+    static constexpr uint8_t LVPP_PROFILE_BUCKETS = 8;
+
+    void printReport();
+    std::string getReport();
+
+protected:
+    static void refrTimerCb(lv_timer_t* pTimer);
+    static void flushCb(lv_disp_drv_t* pDrv, const lv_area_t* pArea, lv_color_t* pColor);
+    static void monitorCb(lv_disp_drv_t* pDrv, uint32_t time, uint32_t px);
+    static uint32_t nowUs();
+    void commitFrame();
+    uint32_t phaseValue(const lvppFrameSample_t& s, lvppProfilePhase phase);
+
+    static lvppProfiler* pActive;   ///< The running profiler - LVGL's callbacks carry no context.
+    lv_disp_t* pDisp = nullptr;
+    lv_timer_cb_t origRefrCb = nullptr;
+    void (*origFlushCb)(lv_disp_drv_t*, const lv_area_t*, lv_color_t*) = nullptr;
+    void (*origMonitorCb)(lv_disp_drv_t*, uint32_t, uint32_t) = nullptr;
+
+    lvppFrameSample_t frames[LVPP_PROFILE_FRAMES];  ///< Ring of the latest frames.
+    uint32_t nextFrame = 0;         ///< Ring slot written next.
+    uint32_t totalFrames = 0;
+
+    // The frame being measured.
+    lvppFrameSample_t current = {};
+    uint32_t flushAccumUs = 0;
+    bool bFramePending = false;     ///< A refresh drew something and awaits commitFrame().
+    bool bInHandler = false;        ///< Inside timerHandler() - commit at its end with the handler time.
+};
+
+/**
+ * @brief Globally available instance of the profiler, in the manner of ESPSystats.
+ * 
+ */
+extern lvppProfiler LVPPProfiler;
+
+#endif // _LVPPPROFILER_H
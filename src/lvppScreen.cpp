@@ -26,6 +26,7 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //
 #include "lvpp.h"
+#include <algorithm>
 
 /**
  * @file lvppScreen.cpp
@@ -39,6 +40,12 @@
 ///
 
 lvppKeyboard* lvppScreen::pKB = nullptr;
+void (*lvppScreen::lockFn)() = nullptr;
+void (*lvppScreen::unlockFn)() = nullptr;
+
+std::vector<lvppScreen*> lvppScreen::screens;
+uint32_t lvppScreen::useCounter = 0;
+size_t lvppScreen::memoryBudget = 0;
 
 lvppScreen::lvppScreen(lv_obj_t* _pInitScreen) {
     if (!_pInitScreen)
@@ -52,33 +59,303 @@ lvppScreen::lvppScreen(lv_obj_t* _pInitScreen) {
         pKB = new lvppKeyboard("KB", pScreen);
     }
     pPriorScreen=nullptr;
+    screens.push_back(this);
+}
+
+lvppScreen::lvppScreen(lvppScreenBuilder _builder) {
+    assert(_builder);
+    buildSteps.push_back(_builder);
+
+    if (!pKB) {
+        pKB = new lvppKeyboard("KB", nullptr);
+    }
+    pPriorScreen=nullptr;
+    screens.push_back(this);
+}
+
+lvppScreen::~lvppScreen() {
+    screens.erase(std::find(screens.begin(), screens.end(), this));
+    for (auto it: screens) {
+        if (it->pPriorLvppScreen == this) {
+            it->pPriorLvppScreen = nullptr;
+            it->pPriorScreen = nullptr;
+        }
+    }
+
+    cancelPrefetch();
+    destroyObjects();
+    if (pScreen)
+        lv_obj_del(pScreen);
+}
+
+// The object as a value widget (bar, slider, arc) - nullptr for other types.
+static lvppBaseWithValue* valueObjOf(lvppBase* pObj) {
+    const std::string& type = pObj->getObjType();
+    if (type=="BAR" || type=="SLIDER" || type=="ARC")
+        return (lvppBaseWithValue*)pObj;
+    return nullptr;
+}
+
+// Bytes in use in LVGL's own heap. Always 0 when LV_MEM_CUSTOM is used.
+static size_t lvHeapUsed() {
+    lv_mem_monitor_t mon;
+
+    lv_mem_monitor(&mon);
+    return mon.total_size - mon.free_size;
+}
+
+void lvppScreen::addBuildStep(lvppScreenBuilder step) {
+    assert(step);
+    buildSteps.push_back(step);
+}
+
+bool lvppScreen::build() {
+    if (isBuilt())
+        return false;
+
+    if (!pScreen)
+        beginBuild();
+
+    // Finishes off a prefetch() in progress too.
+    runBuildSteps(0);
+    return true;
+}
+
+bool lvppScreen::prefetch(uint32_t maxMsPerTick) {
+    if (isBuilt() || pPrefetchTimer)
+        return false;
+
+    if (!pScreen)
+        beginBuild();
+
+    prefetchSliceMs = maxMsPerTick;
+    pPrefetchTimer = lv_timer_create(prefetchTimerCb, 0, this);
+    return true;
+}
+
+void lvppScreen::prefetchTimerCb(lv_timer_t* pTimer) {
+    lvppScreen* pThis = (lvppScreen*)pTimer->user_data;
+    pThis->runBuildSteps(pThis->prefetchSliceMs);
+}
+
+void lvppScreen::cancelPrefetch() {
+    if (pPrefetchTimer) {
+        lv_timer_del(pPrefetchTimer);
+        pPrefetchTimer = nullptr;
+    }
+}
+
+void lvppScreen::beginBuild() {
+    heapAtBuildStart = lvHeapUsed();
+    buildStartTick = lv_tick_get();
+    buildTime = 0;
+    buildSlices = 0;
+    longestBuildSlice = 0;
+
+    pScreen = lv_obj_create(NULL);
+    assert(pScreen);
+    lv_obj_add_flag( pScreen, LV_OBJ_FLAG_SCROLL_ON_FOCUS ); 
+    if (bScrollBarsDisabled)
+        disableScrollBars();
+}
+
+//
+// Run build steps until done or until maxMs (0 for no limit) has passed. At least one step is
+// run per call, so a single step longer than maxMs still makes progress.
+// Returns true once all steps have run.
+//
+bool lvppScreen::runBuildSteps(uint32_t maxMs) {
+    uint32_t start = lv_tick_get();
+
+    // Index based as a step may add further steps.
+    while (nextBuildStep < buildSteps.size()) {
+        buildSteps[nextBuildStep++](this);
+        if (maxMs && lv_tick_elaps(start) >= maxMs)
+            break;
+    }
+
+    uint32_t spent = lv_tick_elaps(start);
+    buildTime += spent;
+    buildSlices++;
+    if (spent > longestBuildSlice)
+        longestBuildSlice = spent;
+
+    if (nextBuildStep < buildSteps.size())
+        return false;
+
+    finishBuild();
+    return true;
+}
+
+void lvppScreen::finishBuild() {
+    cancelPrefetch();
+
+    // The builder recreates the widgets in the same order, so the creation index finds each one -
+    // names needn't be unique, or set at all.
+    for (auto& it: savedValues) {
+        lvppBaseWithValue* pValueObj = it.first < objects.size() ? valueObjOf(objects[it.first]) : nullptr;
+        if (pValueObj)
+            pValueObj->setValue(it.second);
+    }
+    savedValues.clear();
+
+    size_t heapNow = lvHeapUsed();
+    buildCost = (heapNow > heapAtBuildStart ? heapNow - heapAtBuildStart : 0) + arena.getBytesReserved();
+    buildElapsed = lv_tick_elaps(buildStartTick);
+    buildCount++;
+}
+
+//
+// True for a screen LVGL is showing or switching between. lv_scr_load_anim() only queues the new
+// screen in scr_to_load - lv_scr_act() stays the old one until the animation starts, and the old
+// one is then prev_scr until it ends. Deleting either mid-animation would crash LVGL.
+//
+static bool isScreenInUse(lv_obj_t* pScr) {
+    lv_disp_t* pDisp = lv_disp_get_default();
+
+    if (pScr == lv_scr_act())
+        return true;
+    return pDisp && (pScr == pDisp->scr_to_load || pScr == pDisp->prev_scr);
+}
+
+bool lvppScreen::unload() {
+    if (!isLazy() || !pScreen || isScreenInUse(pScreen))
+        return false;
+
+    cancelPrefetch();
+
+    savedValues.clear();
+    for (uint32_t i=0; i<objects.size(); i++) {
+        lvppBaseWithValue* pValueObj = valueObjOf(objects[i]);
+        if (pValueObj)
+            savedValues.emplace_back(i, pValueObj->getValue());
+    }
+
+    destroyObjects();
+    lv_obj_del(pScreen);
+
+    // Other screens may have come here from us. Their pPriorLvppScreen remains so we get rebuilt.
+    for (auto it: screens) {
+        if (it->pPriorScreen == pScreen)
+            it->pPriorScreen = nullptr;
+    }
+
+    pScreen = nullptr;
+    nextBuildStep = 0;
+    buildCost = 0;
+    return true;
+}
+
+lvppScreen* lvppScreen::findScreen(lv_obj_t* pScr) {
+    for (auto it: screens) {
+        if (it->pScreen && it->pScreen == pScr)
+            return it;
+    }
+
+    return nullptr;
+}
+
+size_t lvppScreen::getLoadedCost() {
+    size_t total = 0;
+
+    for (auto it: screens) {
+        if (it->isLazy() && it->isBuilt())
+            total += it->buildCost;
+    }
+
+    return total;
+}
+
+void lvppScreen::enforceMemoryBudget(lvppScreen* pKeep) {
+    if (!memoryBudget)
+        return;
+
+    size_t total = getLoadedCost();
+
+    while (total > memoryBudget) {
+        lvppScreen* pLRU = nullptr;
+
+        for (auto it: screens) {
+            if (!it->isLazy() || !it->isBuilt() || it == pKeep || isScreenInUse(it->pScreen))
+                continue;
+            if (!pLRU || it->lastUsed < pLRU->lastUsed)
+                pLRU = it;
+        }
+
+        if (!pLRU)
+            break;      // Everything left is in use.
+
+        total -= pLRU->buildCost;
+        pLRU->unload();
+    }
+}
+
+void lvppScreen::destroyObjects() {
+    // Delete the LVGL side first. Every wrapper hears LV_EVENT_DELETE and forgets its pointers,
+    // so the wrapper destructors run by the arena have no LVGL work left to do.
+    if (pScreen)
+        lv_obj_clean(pScreen);
+
+    for (auto it: objects)
+        it->setOwnerScreen(nullptr);
+    objects.clear();
+    nameIndex.clear();
+    arena.reset();
+    objGeneration++;
 }
 
 void lvppScreen::disableScrollBars() {
-   lv_obj_clear_flag(pScreen, LV_OBJ_FLAG_SCROLLABLE);
+    bScrollBarsDisabled = true;
+    if (pScreen)
+        lv_obj_clear_flag(pScreen, LV_OBJ_FLAG_SCROLLABLE);
 }
 
 void lvppScreen::activateScreen(uint32_t anim_time, lv_scr_load_anim_t anim_type) {    
+    LVPP_TRACE_SCOPE("activateScreen");
     pPriorScreen = lv_scr_act();
+    pPriorLvppScreen = findScreen(pPriorScreen);
+
+    build();
+    markUsed();
+
     if (anim_time==0 && anim_type==LV_SCR_LOAD_ANIM_NONE) {
         lv_scr_load(pScreen);
     }
     else {
         lv_scr_load_anim(pScreen, anim_type, anim_time, 0, false);
     }
+
+    // The screen we came from may still be animating out, so it is kept this time around. This
+    // screen is protected too: with an animation it is only queued, not yet lv_scr_act().
+    enforceMemoryBudget(pPriorLvppScreen);
 }
 
 void lvppScreen::activatePriorScreen() {
-    if (pPriorScreen) {
+    if (pPriorLvppScreen) {
+        pPriorLvppScreen->build();
+        pPriorLvppScreen->markUsed();
+        lvppScreen* pLeaving = findScreen(lv_scr_act());
+        lv_scr_load(pPriorLvppScreen->pScreen);
+        // We are typically called from a Back button on the screen being left, whose event
+        // handler is still running - so that screen must survive this budget pass.
+        enforceMemoryBudget(pLeaving);
+    }
+    else if (pPriorScreen) {
         lv_scr_load(pPriorScreen);
-        pPriorScreen=nullptr;
     }
+
+    pPriorScreen=nullptr;
+    pPriorLvppScreen=nullptr;
 }
 
 void lvppScreen::addObject(lvppBase* pObj) {
     assert(pObj);
+    if (!pScreen)
+        build();
     objects.push_back(pObj);
     pObj->setNewParent(pScreen);
+    pObj->setOwnerScreen(this);
+    indexObject(pObj);
 
     if (pObj->getObjType()=="TEXTAREA") {
         lvppTextarea* pTA = (lvppTextarea*)pObj;
@@ -89,41 +366,183 @@ void lvppScreen::addObject(lvppBase* pObj) {
     }
 }
 
+//
+// FNV-1a. Cheap, decent distribution for short names and no allocation (unlike building a
+// std::string key from the const char* callers give us).
+//
+uint32_t lvppScreen::hashName(const char* pName) {
+    uint32_t h = 2166136261u;
+
+    while (*pName) {
+        h ^= (uint8_t)*pName++;
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+void lvppScreen::indexObject(lvppBase* pObj) {
+    nameIndex.emplace(hashName(pObj->getFriendlyName().c_str()), pObj);
+}
+
+void lvppScreen::unindexObject(lvppBase* pObj) {
+    auto range = nameIndex.equal_range(hashName(pObj->getFriendlyName().c_str()));
+
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == pObj) {
+            nameIndex.erase(it);
+            return;
+        }
+    }
+}
+
 lvppBase* lvppScreen::findObj(const char* pName) {
-    for(auto it: objects) {
-//        printf("lvppScreen:findObj - looking at: %s\n", it->getFriendlyName().c_str());
-        if (!strcmp(it->getFriendlyName().c_str(), pName))
-            return it;
+    if (!pName)
+        return nullptr;
+
+    auto range = nameIndex.equal_range(hashName(pName));
+    for (auto it = range.first; it != range.second; ++it) {
+//        printf("lvppScreen:findObj - looking at: %s\n", it->second->getFriendlyName().c_str());
+        if (!strcmp(it->second->getFriendlyName().c_str(), pName))
+            return it->second;
     }
 
     return nullptr;
 }
 
-///@todo Support more than just bar and slider for value setting. Get clear on what widgets
-///      should bet settable.
+bool lvppObjHandle::isValid() const {
+    return pObj && (!pOwner || pOwner->getObjGeneration() == generation);
+}
+
+lvppObjHandle lvppScreen::getHandle(const char* pName) {
+    lvppObjHandle h;
+
+    h.pObj = findObj(pName);
+    if (h.pObj) {
+        h.pOwner = this;
+        h.generation = objGeneration;
+        h.pValueObj = valueObjOf(h.pObj);
+        if (h.pObj->getObjType()=="TEXTAREA") {
+            h.pTextareaObj = (lvppTextarea*)h.pObj;
+        }
+    }
+
+    return h;
+}
+
 ///@todo Create a 'getter' version as well.
 ///@todo Create a setObj() possibly for boolean types like buttons?? OR just use 1/0 as the 'val'?
 bool lvppScreen::setObjValue(const char* objName, int16_t val) {
-    lvppBase* pB = findObj(objName);
-    std::string type=pB->getObjType();
-    if (pB) {
-        if (type=="BAR") {
-            lvppBar* pBar = (lvppBar*)pB;
-            if (!pBar)
-                throw std::bad_cast();
-            else
-                pBar->setValue(val);
+    return setObjValue(getHandle(objName), val);
+}
+
+bool lvppScreen::setObjValue(const lvppObjHandle& h, int16_t val) {
+    if (!h.pValueObj || !h.isValid())
+        return false;
+
+    h.pValueObj->setValue(val);
+    return true;
+}
+
+bool lvppScreen::setObjText(const char* objName, const char* pText) {
+    return setObjText(getHandle(objName), pText);
+}
+
+bool lvppScreen::setObjText(const lvppObjHandle& h, const char* pText) {
+    if (!h.isValid())
+        return false;
+
+    // lvppTextarea::setText() has a different signature so it does not override lvppBase::setText().
+    if (h.pTextareaObj)
+        h.pTextareaObj->setText(pText);
+    else
+        h.pObj->setText(pText);
+
+    return true;
+}
+
+uint16_t lvppScreen::applyBatch(lvppBatchItem* pItems, size_t count) {
+    // Each widget touched by the batch, once, however many items address it.
+    struct dirtyObj {
+        lvppBase* pObj;
+        bool bValueSet;
+    };
+    std::vector<dirtyObj> dirty;
+    uint16_t applied = 0;
+
+    if (!pItems || !count)
+        return 0;
+
+    if (!pScreen) {
+        for (size_t i=0; i<count; i++)
+            pItems[i].status = LVPP_BATCH_NOT_FOUND;
+        return 0;
+    }
+
+    if (lockFn)
+        lockFn();
+
+    // Resolve everything first.
+    dirty.reserve(count);
+    for (size_t i=0; i<count; i++) {
+        lvppBatchItem& item = pItems[i];
+
+        if (!item.handle.isValid())
+            item.handle = getHandle(item.pName);
+
+        if (!item.handle.isValid())
+            item.status = LVPP_BATCH_NOT_FOUND;
+        else if (!item.pText && !item.handle.pValueObj)
+            item.status = LVPP_BATCH_WRONG_TYPE;
+        else
+            item.status = LVPP_BATCH_OK;
+
+        if (item.status != LVPP_BATCH_OK)
+            continue;
+
+        applied++;
+        bool bSeen = false;
+        for (auto& it: dirty)
+            bSeen = bSeen || it.pObj == item.handle.pObj;
+        if (!bSeen)
+            dirty.push_back({ item.handle.pObj, false });
+    }
+
+    // Mark the areas the widgets occupy now (a shorter text leaves part of it behind), then apply
+    // with invalidation off - no per-item invalidation and no per-item LV_EVENT_VALUE_CHANGED.
+    lv_disp_t* pDisp = lv_obj_get_disp(pScreen);
+    for (auto& it: dirty)
+        lv_obj_invalidate(it.pObj->getObj());
+
+    bool bWasEnabled = lv_disp_is_invalidation_enabled(pDisp);
+    lv_disp_enable_invalidation(pDisp, false);
+    for (size_t i=0; i<count; i++) {
+        lvppBatchItem& item = pItems[i];
+        if (item.status != LVPP_BATCH_OK)
+            continue;
+
+        if (item.pText) {
+            setObjText(item.handle, item.pText);
         }
-        else if (type=="SLIDER") {
-            lvppSlider* pSlider = (lvppSlider*)pB;
-            if (!pSlider)
-                throw std::bad_cast();
-            else
-                pSlider->setValue(val);
+        else if (item.handle.pValueObj->storeValue(item.value, true)) {
+            for (auto& it: dirty) {
+                if (it.pObj == item.handle.pObj)
+                    it.bValueSet = true;
+            }
         }
-        return true;
     }
-    else {
-        return false;
+    lv_disp_enable_invalidation(pDisp, bWasEnabled);
+
+    // One invalidation and at most one value changed event (value label, bindings, listeners) per
+    // widget. LVGL joins the areas into a single refresh after the unlock.
+    for (auto& it: dirty) {
+        lv_obj_invalidate(it.pObj->getObj());
+        if (it.bValueSet)
+            lv_event_send(it.pObj->getObj(), LV_EVENT_VALUE_CHANGED, NULL);
     }
+
+    if (unlockFn)
+        unlockFn();
+
+    return applied;
 }
@@ -0,0 +1,183 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#ifndef _LVPPSIGNAL_H
+#define _LVPPSIGNAL_H
+
+#include <stdint.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef LV_LVGL_H_INCLUDE_SIMPLE
+#include "lvgl.h"
+#else
+#include "lvgl/lvgl.h"
+#endif
+
+/** @file lvppSignal.h
+ * @brief Multi-listener event callbacks for lvppBase without per-dispatch allocation.
+ */
+
+/**
+ * @brief Maximum number of listeners (across all event types) a single widget can have.
+ *        Can be overridden in platform.ini...build_flags with -D LVPP_MAX_LISTENERS=n
+ */
+#ifndef LVPP_MAX_LISTENERS
+#define LVPP_MAX_LISTENERS 8
+#endif
+
+/**
+ * @brief Bytes of inline storage per listener. Lambdas whose captures fit are stored inline.
+ *        Larger callables still work but are placed on the heap once at connect time.
+ */
+#ifndef LVPP_CALLBACK_INLINE_SIZE
+#define LVPP_CALLBACK_INLINE_SIZE (4*sizeof(void*))
+#endif
+
+/**
+ * @brief Handle returned when connecting a listener. Pass it back to disconnect(). Zero is never a valid handle.
+ */
+typedef uint16_t lvppConnection;
+
+/**
+ * @brief A type-erased `void()` callable with small-buffer storage.
+ * 
+ * This is the moral equivalent of std::function<void()> but it never copies or moves once
+ * assigned and holds typical lambdas (capturing a pointer or two) without touching the heap.
+ */
+class lvppCallback {
+public:
+    lvppCallback() { };
+    ~lvppCallback() { reset(); };
+    lvppCallback(const lvppCallback&) = delete;
+    lvppCallback& operator=(const lvppCallback&) = delete;
+
+    template<typename F>
+    void assign(F&& f) {
+        typedef typename std::decay<F>::type T;
+        reset();
+        assignImpl<T>(std::forward<F>(f),
+            std::integral_constant<bool, sizeof(T) <= LVPP_CALLBACK_INLINE_SIZE && alignof(T) <= alignof(void*)>());
+    };
+    void reset() {
+        if (pDestroy)
+            pDestroy(storage);
+        pInvoke = nullptr;
+        pDestroy = nullptr;
+    };
+    bool isSet() const { return pInvoke != nullptr; };
+    void operator()() { pInvoke(storage); };
+protected:
+    template<typename T, typename F>
+    void assignImpl(F&& f, std::true_type) {
+        new (storage) T(std::forward<F>(f));
+        pInvoke = [](void* p) { (*static_cast<T*>(p))(); };
+        pDestroy = [](void* p) { static_cast<T*>(p)->~T(); };
+    };
+    template<typename T, typename F>
+    void assignImpl(F&& f, std::false_type) {
+        *reinterpret_cast<T**>(storage) = new T(std::forward<F>(f));
+        pInvoke = [](void* p) { (**static_cast<T**>(p))(); };
+        pDestroy = [](void* p) { delete *static_cast<T**>(p); };
+    };
+    alignas(void*) unsigned char storage[LVPP_CALLBACK_INLINE_SIZE];
+    void (*pInvoke)(void*) = nullptr;
+    void (*pDestroy)(void*) = nullptr;
+};
+
+/**
+ * @brief Fixed table of listeners keyed by LVGL event code. One of these is created on demand
+ *        for each widget which has listeners.
+ * 
+ * Dispatch is a loop over the inline slots - no allocation and no indirection beyond the call
+ * itself. Listeners may connect or disconnect (including themselves) from within a callback;
+ * removal takes effect immediately and new listeners start receiving events with the next emit().
+ * A listener may also delete the widget itself: the remaining listeners are then skipped and the
+ * table is freed once emit() has unwound (see release()).
+ */
+class lvppEventSignals {
+public:
+/**
+ * @brief Add a listener for the event code.
+ * 
+ * @return lvppConnection handle for disconnect(), or 0 if all LVPP_MAX_LISTENERS slots are in use.
+ */
+    template<typename F>
+    lvppConnection connect(lv_event_code_t code, F&& f) {
+        for (auto& s: slots) {
+            if (s.id || s.cb.isSet())
+                continue;
+            s.cb.assign(std::forward<F>(f));
+            s.code = code;
+            s.bArmed = (emitDepth == 0);
+            s.id = nextId++;
+            if (!nextId)
+                nextId = 1;
+            if (!s.bArmed)
+                bNeedsCleanup = true;
+            return s.id;
+        }
+
+        LV_LOG_WARN("lvppEventSignals::connect - no free listener slots. Increase LVPP_MAX_LISTENERS.\n");
+        return 0;
+    };
+/**
+ * @brief Remove a listener previously added by connect().
+ * 
+ * @return true if the handle was found and removed.
+ */
+    bool disconnect(lvppConnection c);
+/**
+ * @brief Call every listener registered for the event code in slot order. Slots freed by
+ *        disconnect() are reused, so this is only connection order while nothing was disconnected.
+ */
+    void emit(lv_event_code_t code);
+/**
+ * @brief Free the table - used by the owning widget's destructor in place of delete. From within
+ *        a listener the free is deferred until the outermost emit() returns.
+ */
+    void release();
+/**
+ * @brief Number of listeners currently registered for the event code.
+ */
+    uint8_t getListenerCount(lv_event_code_t code);
+protected:
+    struct slot {
+        lvppCallback cb;
+        lvppConnection id = 0;                  ///< 0 when the slot is free (or pending cleanup).
+        lv_event_code_t code = LV_EVENT_ALL;
+        bool bArmed = false;                    ///< False for listeners added during an emit().
+    };
+    slot slots[LVPP_MAX_LISTENERS];
+    lvppConnection nextId = 1;
+    uint8_t emitDepth = 0;                      ///< Callbacks can trigger nested events on the same widget.
+    bool bNeedsCleanup = false;
+    bool bOrphaned = false;                     ///< release() was called during an emit().
+};
+
+#endif
@@ -0,0 +1,93 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#include "lvppStyle.h"
+
+/** @file lvppStyle.cpp
+ * @brief Implementation of the shared style registry (lvppStyleRegistry).
+ */
+
+std::map<lvppStyleProps, lvppSharedStyle> lvppStyleRegistry::styles;
+uint32_t lvppStyleRegistry::totalRefs = 0;
+
+bool lvppStyleProps::operator<(const lvppStyleProps& rhs) const {
+    if (setMask != rhs.setMask)
+        return setMask < rhs.setMask;
+
+    if ((setMask & PROP_TEXT_FONT) && textFont != rhs.textFont)
+        return textFont < rhs.textFont;
+    if ((setMask & PROP_TEXT_COLOR) && textColor.full != rhs.textColor.full)
+        return textColor.full < rhs.textColor.full;
+    if ((setMask & PROP_ARC_COLOR) && arcColor.full != rhs.arcColor.full)
+        return arcColor.full < rhs.arcColor.full;
+    if ((setMask & PROP_PAD_ALL) && padAll != rhs.padAll)
+        return padAll < rhs.padAll;
+
+    return false;
+}
+
+lvppSharedStyle* lvppStyleRegistry::acquire(const lvppStyleProps& props) {
+    assert(!props.isEmpty());
+
+    auto it = styles.find(props);
+    if (it == styles.end()) {
+        it = styles.emplace(props, lvppSharedStyle()).first;
+        lv_style_t* pStyle = &it->second.style;
+        it->second.props = props;
+
+        lv_style_init(pStyle);
+        if (props.setMask & lvppStyleProps::PROP_TEXT_FONT)
+            lv_style_set_text_font(pStyle, props.textFont);
+        if (props.setMask & lvppStyleProps::PROP_TEXT_COLOR)
+            lv_style_set_text_color(pStyle, props.textColor);
+        if (props.setMask & lvppStyleProps::PROP_ARC_COLOR)
+            lv_style_set_arc_color(pStyle, props.arcColor);
+        if (props.setMask & lvppStyleProps::PROP_PAD_ALL)
+            lv_style_set_pad_all(pStyle, props.padAll);
+    }
+
+    it->second.refCount++;
+    totalRefs++;
+    return &it->second;
+}
+
+void lvppStyleRegistry::release(lvppSharedStyle* pShared) {
+    if (!pShared)
+        return;
+
+    assert(pShared->refCount);
+    pShared->refCount--;
+    totalRefs--;
+
+    if (pShared->refCount)
+        return;
+
+    // Last user is gone - free the style's property storage and drop the map node.
+    lvppStyleProps key = pShared->props;
+    lv_style_reset(&pShared->style);
+    styles.erase(key);
+}
@@ -0,0 +1,127 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#ifndef _LVPPSTYLE_H
+#define _LVPPSTYLE_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <map>
+
+#ifdef LV_LVGL_H_INCLUDE_SIMPLE
+#include "lvgl.h"
+#else
+#include "lvgl/lvgl.h"
+#endif
+
+/** @file lvppStyle.h
+ * @brief Shared (interned) style support for lvppBase widgets.
+ */
+
+/**
+ * @brief The set of style properties that lvpp widgets manage on their main object.
+ * 
+ * Only the properties which have been explicitly set (per setMask) take part in comparisons,
+ * so two widgets which only ever called setFontSize(14) end up with identical props and
+ * therefore share a single lv_style_t via lvppStyleRegistry.
+ */
+struct lvppStyleProps {
+    enum : uint8_t {
+        PROP_TEXT_FONT  = 0x01,
+        PROP_TEXT_COLOR = 0x02,
+        PROP_PAD_ALL    = 0x04,
+        PROP_ARC_COLOR  = 0x08,
+    };
+
+    uint8_t setMask = 0;                    ///< Which of the properties below are in use.
+    const lv_font_t* textFont = nullptr;
+    lv_color_t textColor;
+    lv_color_t arcColor;
+    lv_coord_t padAll = 0;
+
+    void setTextFont(const lv_font_t* pF) { textFont = pF; setMask |= PROP_TEXT_FONT; };
+    void setTextColor(lv_color_t col) { textColor = col; setMask |= PROP_TEXT_COLOR; };
+    void setArcColor(lv_color_t col) { arcColor = col; setMask |= PROP_ARC_COLOR; };
+    void setPadAll(lv_coord_t pad) { padAll = pad; setMask |= PROP_PAD_ALL; };
+    bool isEmpty() const { return setMask == 0; };
+/**
+ * @brief Strict weak ordering so props can be used as a std::map key. Unset properties are ignored.
+ */
+    bool operator<(const lvppStyleProps& rhs) const;
+};
+
+/**
+ * @brief One interned style. The lv_style_t lives inside the registry's map node, so its
+ *        address is stable for as long as any widget holds a reference to it.
+ */
+struct lvppSharedStyle {
+    lv_style_t style;           ///< The LVGL style shared by every widget with identical props.
+    lvppStyleProps props;       ///< Copy of the key so release() can erase without a search.
+    uint32_t refCount = 0;      ///< Number of widgets currently using this style.
+};
+
+/**
+ * @brief Registry which deduplicates style property sets across all lvpp widgets.
+ * 
+ * Shared styles are treated as immutable. When a widget changes one of its properties it
+ * acquires the style matching its new property set (creating it if needed) and releases the
+ * old one - copy-on-write from the widget's point of view. A style is reset and freed once
+ * the last widget releases it.
+ * 
+ * _Note: LVGL is not thread safe and neither is this registry. Use it from the LVGL thread._
+ */
+class lvppStyleRegistry {
+public:
+/**
+ * @brief Find (or create) the shared style for the given props and add a reference to it.
+ * 
+ * @param props The property set being requested. Must not be empty.
+ * @return lvppSharedStyle* The shared style. Never nullptr.
+ */
+    static lvppSharedStyle* acquire(const lvppStyleProps& props);
+/**
+ * @brief Drop a reference to a shared style. The caller must already have removed the style
+ *        from any LVGL objects it was attached to.
+ * 
+ * @param pShared Style previously returned by acquire(). nullptr is ignored.
+ */
+    static void release(lvppSharedStyle* pShared);
+/**
+ * @brief Number of distinct styles currently alive in the registry.
+ */
+    static uint32_t getStyleCount() { return (uint32_t)styles.size(); };
+/**
+ * @brief Total number of widget references across all shared styles. Comparing this to
+ *        getStyleCount() shows how many lv_style_t objects the sharing has saved.
+ */
+    static uint32_t getReferenceCount() { return totalRefs; };
+protected:
+    static std::map<lvppStyleProps, lvppSharedStyle> styles;   ///< Interned styles keyed by their props.
+    static uint32_t totalRefs;                                  ///< Sum of all refCount values.
+};
+
+#endif
@@ -43,6 +43,7 @@ lvppTextarea::lvppTextarea(const char* fName, const char* pText, lv_obj_t* paren
 }
 
 void lvppTextarea::setText(const char* pText, const char* pPlaceholder) {
+    LVPP_TRACE_SCOPE("setText");
     if (pText) {
         lv_textarea_set_text(obj, pText);
     }
@@ -60,8 +61,8 @@ const char * lvppTextarea::getText() {
  * 
 */
 void lvppTextarea::setTextColor(lv_color_t newColor) {
-    lv_style_set_text_color(&style_obj, newColor);
-    lv_obj_add_style(obj, &style_obj, 0);
+    styleProps.setTextColor(newColor);
+    applySharedStyle();
 }
 
 void lvppTextarea::eventHandler(lv_event_t* event) {
@@ -75,7 +76,8 @@ void lvppTextarea::eventHandler(lv_event_t* event) {
     switch(code) {
         case LV_EVENT_FOCUSED:
             if (pKB) {
-                pKB->enableKeyboard();
+                // Shown on the textarea's own screen, which during a screen transition need not be lv_scr_act().
+                pKB->enableKeyboard(true, lv_obj_get_screen(ta));
                 lv_keyboard_set_textarea(pKB->getObj(), ta);
             }
 //failed            lv_obj_scroll_to_view_recursive(ta, LV_ANIM_ON);
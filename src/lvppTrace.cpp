@@ -0,0 +1,189 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#include "lvppTrace.h"
+
+#ifdef ESP_PLATFORM
+#include "Arduino.h"
+#else
+#include <chrono>
+#endif
+#include <stdio.h>
+
+/**
+ * @file lvppTrace.cpp
+ * @brief Per-thread trace rings and the Chrome trace exporter.
+ */
+
+#if LVPP_TRACE
+
+#include <atomic>
+
+/**
+ * @brief One thread's events. Only the owning thread writes; head is published with release
+ *        ordering so an exporter on another thread sees complete events. A slot is reused once
+ *        head has moved a whole ring past it, so the exporter copies an event and then checks
+ *        head again - seqlock style - to drop any it may have read mid-overwrite.
+ */
+struct lvppTraceRing {
+    std::atomic<uint32_t> head;     ///< Events ever written - the next slot is head % LVPP_TRACE_EVENTS.
+    lvppTraceEvent_t events[LVPP_TRACE_EVENTS];
+};
+
+static lvppTraceRing rings[LVPP_TRACE_THREADS];
+static std::atomic<uint32_t> ringsClaimed(0);
+static std::atomic<uint32_t> dropped(0);
+
+static lvppTraceRing* threadRing() {
+    static thread_local lvppTraceRing* pRing = nullptr;
+    static thread_local bool bClaimed = false;
+
+    if (!bClaimed) {
+        bClaimed = true;
+        uint32_t i = ringsClaimed.fetch_add(1);
+        pRing = i < LVPP_TRACE_THREADS ? &rings[i] : nullptr;
+    }
+    return pRing;
+}
+
+uint32_t lvppTrace::nowUs() {
+#ifdef ESP_PLATFORM
+    return micros();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void lvppTrace::record(const char* pName, uint32_t startUs, uint32_t durUs) {
+    lvppTraceRing* pRing = threadRing();
+    if (!pRing) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint32_t h = pRing->head.load(std::memory_order_relaxed);
+    // Keep the slot writes after the previous head store, so an exporter that sees the old head
+    // again can trust what it copied.
+    std::atomic_thread_fence(std::memory_order_release);
+    lvppTraceEvent_t& ev = pRing->events[h % LVPP_TRACE_EVENTS];
+    ev.pName = pName;
+    ev.startUs = startUs;
+    ev.durUs = durUs;
+    pRing->head.store(h + 1, std::memory_order_release);
+}
+
+uint32_t lvppTrace::exportChrome(void (*writeFn)(const char* pText, void* pCtx), void* pCtx) {
+    char line[160];
+    uint32_t written = 0;
+    uint32_t claimed = ringsClaimed.load();
+    if (claimed > LVPP_TRACE_THREADS)
+        claimed = LVPP_TRACE_THREADS;
+
+    writeFn("{\"traceEvents\":[\n", pCtx);
+    for (uint32_t t=0; t<claimed; t++) {
+        uint32_t head = rings[t].head.load(std::memory_order_acquire);
+        uint32_t first = head > LVPP_TRACE_EVENTS ? head - LVPP_TRACE_EVENTS : 0;
+
+        for (uint32_t i=first; i<head; i++) {
+            lvppTraceEvent_t ev = rings[t].events[i % LVPP_TRACE_EVENTS];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t newHead = rings[t].head.load(std::memory_order_relaxed);
+            if (newHead < head)
+                break;          // clear() ran meanwhile.
+            if (newHead - i >= LVPP_TRACE_EVENTS)
+                continue;       // The writer has reached this slot again - the copy may be torn.
+
+            snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,\"pid\":1,\"tid\":%lu}",
+                     written ? ",\n" : "", ev.pName ? ev.pName : "?",
+                     (unsigned long)ev.startUs, (unsigned long)ev.durUs, (unsigned long)t);
+            writeFn(line, pCtx);
+            written++;
+        }
+    }
+    writeFn("\n],\"displayTimeUnit\":\"ms\"}\n", pCtx);
+
+    return written;
+}
+
+void lvppTrace::clear() {
+    uint32_t claimed = ringsClaimed.load();
+    for (uint32_t t=0; t<claimed && t<LVPP_TRACE_THREADS; t++)
+        rings[t].head.store(0, std::memory_order_release);
+    dropped.store(0);
+}
+
+uint32_t lvppTrace::getDropped() {
+    return dropped.load();
+}
+
+#else
+
+uint32_t lvppTrace::nowUs() { return 0; }
+void lvppTrace::record(const char*, uint32_t, uint32_t) { }
+void lvppTrace::clear() { }
+uint32_t lvppTrace::getDropped() { return 0; }
+
+uint32_t lvppTrace::exportChrome(void (*writeFn)(const char* pText, void* pCtx), void* pCtx) {
+    writeFn("{\"traceEvents\":[]}\n", pCtx);
+    return 0;
+}
+
+#endif
+
+#ifndef ESP_PLATFORM
+static void writeFile(const char* pText, void* pCtx) {
+    fputs(pText, (FILE*)pCtx);
+}
+#endif
+
+static void writeConsole(const char* pText, void* pCtx) {
+    (void)pCtx;
+#ifdef ESP_PLATFORM
+    Serial.print(pText);
+#else
+    fputs(pText, stdout);
+#endif
+}
+
+bool lvppTrace::saveChromeTrace(const char* pPath) {
+#ifdef ESP_PLATFORM
+    (void)pPath;
+    return false;
+#else
+    FILE* f = fopen(pPath, "w");
+    if (!f)
+        return false;
+
+    exportChrome(writeFile, f);
+    return fclose(f) == 0;
+#endif
+}
+
+void lvppTrace::printChromeTrace() {
+    exportChrome(writeConsole, nullptr);
+}
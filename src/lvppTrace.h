@@ -0,0 +1,138 @@
+// Copyright 2023 Robert M. Wolff (bob dot wolff 68 at gmail dot com)
+//
+// Redistribution and use in source and binary forms, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this 
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, 
+// this list of conditions and the following disclaimer in the documentation and/or 
+// other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors 
+// may be used to endorse or promote products derived from this software without 
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#ifndef _LVPPTRACE_H
+#define _LVPPTRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** @file lvppTrace.h
+ * @brief Scoped trace markers for lvpp's entry points, exportable as a Chrome trace / Perfetto timeline.
+ * 
+ * Build with -D LVPP_TRACE=1 to enable. Otherwise LVPP_TRACE_SCOPE() compiles to nothing and the
+ * export functions only report that tracing is off.
+ * 
+ * Each thread which records gets its own ring of LVPP_TRACE_EVENTS events (name, start, duration)
+ * written without locks - the newest events overwrite the oldest. lvppTrace::saveChromeTrace() (host)
+ * or lvppTrace::printChromeTrace() (Serial on device - save the output to a .json file) stream
+ * the rings out as Chrome trace JSON which chrome://tracing and ui.perfetto.dev open directly.
+ */
+
+#ifndef LVPP_TRACE
+#define LVPP_TRACE 0
+#endif
+
+/**
+ * @brief Events kept per thread. Can be overridden in platform.ini...build_flags with -D LVPP_TRACE_EVENTS=n
+ */
+#ifndef LVPP_TRACE_EVENTS
+#define LVPP_TRACE_EVENTS 256
+#endif
+
+/**
+ * @brief Number of threads which may record. Further threads' events are dropped.
+ *        Can be overridden in platform.ini...build_flags with -D LVPP_TRACE_THREADS=n
+ */
+#ifndef LVPP_TRACE_THREADS
+#define LVPP_TRACE_THREADS 4
+#endif
+
+/**
+ * @brief One recorded scope. pName must have static lifetime - normally a string literal.
+ */
+typedef struct lvppTraceEvent {
+    const char* pName;
+    uint32_t startUs;
+    uint32_t durUs;
+} lvppTraceEvent_t;
+
+/**
+ * @brief Recording and export of trace events. All static.
+ */
+class lvppTrace {
+public:
+/**
+ * @brief Record a finished scope on the calling thread's ring.
+ */
+    static void record(const char* pName, uint32_t startUs, uint32_t durUs);
+/**
+ * @brief Microsecond timestamp used for events.
+ */
+    static uint32_t nowUs();
+/**
+ * @brief Stream all held events as Chrome trace JSON. Other threads may keep recording meanwhile;
+ *        events overwritten while they were being copied are left out.
+ * 
+ * @param writeFn Called with successive pieces of the JSON text.
+ * @param pCtx Passed through to writeFn.
+ * @return uint32_t Number of events written.
+ */
+    static uint32_t exportChrome(void (*writeFn)(const char* pText, void* pCtx), void* pCtx);
+/**
+ * @brief Write the Chrome trace JSON to a file. Host builds only - returns false on device.
+ */
+    static bool saveChromeTrace(const char* pPath);
+/**
+ * @brief Print the Chrome trace JSON with Serial (device) or printf() (host).
+ */
+    static void printChromeTrace();
+/**
+ * @brief Forget all held events. Call while quiescent - no other thread recording or exporting -
+ *        as a scope finishing meanwhile may restore its ring's old head.
+ */
+    static void clear();
+/**
+ * @brief Events not recorded because more than LVPP_TRACE_THREADS threads recorded.
+ */
+    static uint32_t getDropped();
+};
+
+#if LVPP_TRACE
+/**
+ * @brief Records its lifetime as one event. Use through LVPP_TRACE_SCOPE().
+ */
+class lvppTraceScope {
+public:
+    lvppTraceScope(const char* _pName) : pName(_pName), startUs(lvppTrace::nowUs()) { };
+    ~lvppTraceScope() { lvppTrace::record(pName, startUs, lvppTrace::nowUs() - startUs); };
+protected:
+    const char* pName;
+    uint32_t startUs;
+};
+
+#define LVPP_TRACE_CAT2(a, b) a##b
+#define LVPP_TRACE_CAT(a, b) LVPP_TRACE_CAT2(a, b)
+/**
+ * @brief Trace the rest of the enclosing scope under name (a string literal).
+ */
+#define LVPP_TRACE_SCOPE(name) lvppTraceScope LVPP_TRACE_CAT(_lvppTrace, __LINE__)(name)
+#else
+#define LVPP_TRACE_SCOPE(name) ((void)0)
+#endif
+
+#endif // _LVPPTRACE_H
@@ -27,6 +27,41 @@
 //
 #include "lvppUtils.h"
 
+#ifdef LV_LVGL_H_INCLUDE_SIMPLE
+#include "lvgl.h"
+#else
+#include "lvgl/lvgl.h"
+#endif
+
+#include <string.h>
+#include <algorithm>
+#ifndef ESP_PLATFORM
+#include <stdio.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#include <mach/mach.h>
+#endif
+#endif
+
+// Where the host build finds its heap and RSS figures - the fields stay 0 without one.
+#ifndef ESP_PLATFORM
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#define HOST_HEAP_SOURCE "mallinfo2()"
+#elif defined(__GLIBC__)
+#define HOST_HEAP_SOURCE "mallinfo()"
+#elif defined(__APPLE__)
+#define HOST_HEAP_SOURCE "mstats()"
+#endif
+#if defined(__APPLE__)
+#define HOST_RSS_SOURCE "task_info()"
+#elif defined(__linux__)
+#define HOST_RSS_SOURCE "/proc/self/statm"
+#endif
+#endif
+
 /** @file lvppUtils.cpp
  *  @brief A few useful items for ESP32 use and printing.
  * 
@@ -82,17 +117,20 @@ void espSystats::takeSampleAndPrintResults(const char* sampName) {
 std::string espSystats::takeSampleAndGetResults(const char* sampName) {
     std::stringstream rpt;
 
-#ifdef ESP_PLATFORM
     takeSample(sampName);
-    espRec_t rec = samples.back();
+    const espRec_t& rec = sampleAt(sampleCount - 1);
     // Now print out the static info and the record info
     rpt << getStaticStats();
     rpt << "ESP Heap Free: " << rec.heapFree;
     rpt << ", Largest Heap Block: " << rec.heapLargestBlock;
     rpt << ", Lowest Heap Free Watermark: " << rec.heapLowWaterMark << std::endl;
-#else
-    rpt << "ESP Systats: Not running on ESP32 - no stats.\n";
+    rpt << "LVGL Heap Free: " << rec.lvFree;
+    rpt << ", Biggest Free Block: " << rec.lvBiggestFree;
+    rpt << ", Fragmentation: " << (int)rec.lvFragPct << "%";
+#ifndef ESP_PLATFORM
+    rpt << ", RSS: " << rec.rssBytes;
 #endif
+    rpt << std::endl;
     return rpt.str();
 }
 
@@ -108,7 +146,16 @@ std::stringstream rpt;
     rpt << ", Sketch Size: " << sketchSize;
     rpt << ", Sketch Free Space: " << sketchFreeSpace << std::endl;
 #else
-    rpt << "ESP Systats: Not running on ESP32 - no stats.\n";
+#ifdef HOST_HEAP_SOURCE
+    rpt << "HOST STATS: heap from " HOST_HEAP_SOURCE;
+#else
+    rpt << "HOST STATS: heap unavailable (reported as 0)";
+#endif
+#ifdef HOST_RSS_SOURCE
+    rpt << ", RSS from " HOST_RSS_SOURCE << std::endl;
+#else
+    rpt << ", RSS unavailable (reported as 0)" << std::endl;
+#endif
 #endif
     return rpt.str();
 }
@@ -120,47 +167,287 @@ void espSystats::printFullReport() {
 
 std::string espSystats::getFullReport() {
     std::stringstream rpt;
-#ifdef ESP_PLATFORM
     constexpr int fWid = 10;
-    constexpr int tWid = fWid + fWid + fWid + fWid + 36;    // Fields are "|" + space + 7 + space
+#ifdef ESP_PLATFORM
+    constexpr int nFields = 7;
+#else
+    constexpr int nFields = 8;
+#endif
+    constexpr int tWid = fWid * nFields + 36;    // Fields are "|" + space + 7 + space
     rpt << getStaticStats();
     rpt << std::left;       // Left align in fields instead of right by default
     rpt.fill('-');
     rpt << std::setw(tWid) << '-' << std::endl;
     rpt.fill(' ');
-    rpt << "| HEAPSIZ | FREE    | LARGEST | MIN     " << std::setw(35) << "| SAMPLE NAME" << "|" << std::endl;
+    rpt << "| HEAPSIZ | FREE    | LARGEST | MIN     | LV_FREE | LV_BIG  | FRAG    ";
+#ifndef ESP_PLATFORM
+    rpt << "| RSS     ";
+#endif
+    rpt << std::setw(35) << "| SAMPLE NAME" << "|" << std::endl;
     rpt.fill('-');
     rpt << std::setw(tWid) << '-' << std::endl;
     rpt.fill(' ');
-    for(auto it: samples) {
+    for(uint32_t i=0; i<getSampleCount(); i++) {
+        if (i == sampleCount) {
+            // Automatic samples follow in their own ring.
+            rpt.fill('-');
+            rpt << std::setw(tWid) << "| AUTO SAMPLES " << std::endl;
+            rpt.fill(' ');
+        }
+        const espRec_t& it = sampleAt(i);
         rpt << "| " << std::setw(fWid-2) << it.heapSize;
         rpt << "| " << std::setw(fWid-2) << it.heapFree;
         rpt << "| " << std::setw(fWid-2) << it.heapLargestBlock;
         rpt << "| " << std::setw(fWid-2) << it.heapLowWaterMark;
+        rpt << "| " << std::setw(fWid-2) << it.lvFree;
+        rpt << "| " << std::setw(fWid-2) << it.lvBiggestFree;
+        rpt << "| " << std::setw(fWid-2) << (int)it.lvFragPct;
+#ifndef ESP_PLATFORM
+        rpt << "| " << std::setw(fWid-2) << it.rssBytes;
+#endif
+        rpt << "| " << std::setw(32) << it.sampleName << " |" << std::endl;
+    }
+    rpt.fill('-');
+    rpt << std::setw(tWid) << '-' << std::endl;
+    return rpt.str();
+}
+
+bool espSystats::getLatestSample(espRec_t& rec) {
+    if (bLatestAuto && autoCount)
+        rec = sampleAt(sampleCount + autoCount - 1);
+    else if (sampleCount)
+        rec = sampleAt(sampleCount - 1);
+    else
+        return false;
+
+    return true;
+}
+
+const espRec_t& espSystats::sampleAt(uint32_t index) {
+    if (index < sampleCount)
+        return samples[(nextSample + LVPP_SYSTATS_SAMPLES - sampleCount + index) % LVPP_SYSTATS_SAMPLES];
+
+    index -= sampleCount;
+    return autoSamples[(nextAuto + LVPP_SYSTATS_AUTO_SAMPLES - autoCount + index) % LVPP_SYSTATS_AUTO_SAMPLES];
+}
+
+void espSystats::aggregate(const espRec_t& rec) {
+    espAgg_t* pAgg = nullptr;
+    for (uint16_t i=0; i<aggCount && !pAgg; i++) {
+        if (!strcmp(aggs[i].sampleName, rec.sampleName))
+            pAgg = &aggs[i];
+    }
+
+    if (!pAgg) {
+        if (aggCount >= LVPP_SYSTATS_NAMES)
+            return;     // Name table full - the sample is still in the ring.
+        pAgg = &aggs[aggCount++];
+        memset(pAgg, 0, sizeof(*pAgg));
+        strcpy(pAgg->sampleName, rec.sampleName);
+        pAgg->heapFreeMin = pAgg->lvFreeMin = UINT32_MAX;
+    }
+
+    pAgg->count++;
+    pAgg->heapFreeMin = std::min(pAgg->heapFreeMin, rec.heapFree);
+    pAgg->heapFreeMax = std::max(pAgg->heapFreeMax, rec.heapFree);
+    pAgg->heapFreeSum += rec.heapFree;
+    pAgg->lvFreeMin = std::min(pAgg->lvFreeMin, rec.lvFree);
+    pAgg->lvFreeMax = std::max(pAgg->lvFreeMax, rec.lvFree);
+    pAgg->lvFreeSum += rec.lvFree;
+}
+
+bool espSystats::getAggregate(const char* sampName, espAgg_t& agg) {
+    for (uint16_t i=0; i<aggCount; i++) {
+        if (!strncmp(aggs[i].sampleName, sampName, MAX_SAMPLENAME)) {
+            agg = aggs[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+void espSystats::printAggregateReport() {
+    std::string s = getAggregateReport();
+    printStr(s);
+}
+
+std::string espSystats::getAggregateReport() {
+    std::stringstream rpt;
+    constexpr int fWid = 10;
+    constexpr int tWid = fWid * 7 + 36;    // Fields are "|" + space + 7 + space
+    rpt << std::left;
+    rpt.fill('-');
+    rpt << std::setw(tWid) << '-' << std::endl;
+    rpt.fill(' ');
+    rpt << "| COUNT   | FREEMIN | FREEMAX | FREEAVG | LV_MIN  | LV_MAX  | LV_AVG  " << std::setw(35) << "| SAMPLE NAME" << "|" << std::endl;
+    rpt.fill('-');
+    rpt << std::setw(tWid) << '-' << std::endl;
+    rpt.fill(' ');
+    for (uint16_t i=0; i<aggCount; i++) {
+        const espAgg_t& it = aggs[i];
+        rpt << "| " << std::setw(fWid-2) << it.count;
+        rpt << "| " << std::setw(fWid-2) << it.heapFreeMin;
+        rpt << "| " << std::setw(fWid-2) << it.heapFreeMax;
+        rpt << "| " << std::setw(fWid-2) << (uint32_t)(it.heapFreeSum / it.count);
+        rpt << "| " << std::setw(fWid-2) << it.lvFreeMin;
+        rpt << "| " << std::setw(fWid-2) << it.lvFreeMax;
+        rpt << "| " << std::setw(fWid-2) << (uint32_t)(it.lvFreeSum / it.count);
         rpt << "| " << std::setw(32) << it.sampleName << " |" << std::endl;
     }
     rpt.fill('-');
     rpt << std::setw(tWid) << '-' << std::endl;
-#else
-    rpt << "ESP Systats: Not running on ESP32 - no stats.\n";
-#endif
     return rpt.str();
 }
 
-void espSystats::recordSample(const char* sampName) {
+void espSystats::autoSampleCb(lv_timer_t* pTimer) {
+    espSystats* pStats = (espSystats*)pTimer->user_data;
+    pStats->recordSample(pStats->autoName, true);
+}
+
+void espSystats::startAutoSample(uint32_t periodMs, const char* sampName) {
+    strncpy(autoName, sampName ? sampName : "auto", MAX_SAMPLENAME);
+    autoName[MAX_SAMPLENAME] = 0;
+
+    if (pAutoTimer)
+        lv_timer_set_period(pAutoTimer, periodMs);
+    else
+        pAutoTimer = lv_timer_create(autoSampleCb, periodMs, this);
+}
+
+void espSystats::stopAutoSample() {
+    if (pAutoTimer) {
+        lv_timer_del(pAutoTimer);
+        pAutoTimer = nullptr;
+    }
+}
+
+void espSystats::writeCSV(void (*writeFn)(const char* pText, void* pCtx), void* pCtx) {
+    char line[256];
+    char name[MAX_SAMPLENAME*2+3];
+
+    writeFn("heapSize,heapFree,heapLargestBlock,heapLowWaterMark,lvFree,lvBiggestFree,lvFragPct,lvUsedPct,rssBytes,sampleName\n", pCtx);
+    for (uint32_t i=0; i<getSampleCount(); i++) {
+        const espRec_t& r = sampleAt(i);
+
+        // Names are free text - quote them and double any quotes (RFC 4180).
+        char* pOut = name;
+        *pOut++ = '"';
+        for (const char* pIn = r.sampleName; *pIn; pIn++) {
+            if (*pIn == '"')
+                *pOut++ = '"';
+            *pOut++ = *pIn;
+        }
+        *pOut++ = '"';
+        *pOut = 0;
+
+        snprintf(line, sizeof(line), "%lu,%lu,%lu,%lu,%lu,%lu,%u,%u,%llu,%s\n",
+                 (unsigned long)r.heapSize, (unsigned long)r.heapFree, (unsigned long)r.heapLargestBlock,
+                 (unsigned long)r.heapLowWaterMark, (unsigned long)r.lvFree, (unsigned long)r.lvBiggestFree,
+                 r.lvFragPct, r.lvUsedPct, (unsigned long long)r.rssBytes, name);
+        writeFn(line, pCtx);
+    }
+}
+
+static void writeConsole(const char* pText, void* pCtx) {
+    (void)pCtx;
 #ifdef ESP_PLATFORM
+    Serial.print(pText);
+#else
+    fputs(pText, stdout);
+#endif
+}
+
+void espSystats::printCSV() {
+    writeCSV(writeConsole, nullptr);
+}
+
+void espSystats::writeBinary(void (*writeFn)(const void* pData, size_t len, void* pCtx), void* pCtx) {
+    uint8_t hdr[12] = { 'E', 'S', 'P', 'S' };
+    uint16_t version = 2;
+    uint16_t recSize = sizeof(espRec_t);
+    memcpy(hdr + 4, &version, 2);
+    memcpy(hdr + 6, &recSize, 2);
+    uint32_t count = getSampleCount();
+    memcpy(hdr + 8, &count, 4);
+    writeFn(hdr, sizeof(hdr), pCtx);
+
+    for (uint32_t i=0; i<count; i++)
+        writeFn(&sampleAt(i), sizeof(espRec_t), pCtx);
+}
+
+void espSystats::recordSample(const char* sampName, bool bAuto) {
     espRec_t rec;
-    if (samples.size() > 50) {
-        Serial.printf("WARNING: espSystats sample count exceeds 50. This is unusal. Current count is: %u\n", samples.size());
-    }
+    memset(&rec, 0, sizeof(rec));
+#ifdef ESP_PLATFORM
     rec.heapFree = ESP.getFreeHeap();
     rec.heapSize = ESP.getHeapSize();
     rec.heapLargestBlock = ESP.getMaxAllocHeap();
     rec.heapLowWaterMark = ESP.getMinFreeHeap();
+#else
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+#elif defined(__GLIBC__)
+    struct mallinfo mi = mallinfo();
+#endif
+#ifdef __GLIBC__
+    rec.heapSize = (uint32_t)(mi.arena + mi.hblkhd);
+    rec.heapFree = (uint32_t)mi.fordblks;
+#elif defined(__APPLE__)
+    struct mstats ms = mstats();
+    rec.heapSize = (uint32_t)ms.bytes_total;
+    rec.heapFree = (uint32_t)ms.bytes_free;
+#endif
+#ifdef HOST_HEAP_SOURCE
+    lowestHeapFree = std::min(lowestHeapFree, rec.heapFree);
+    rec.heapLowWaterMark = lowestHeapFree;
+#endif
+
+#if defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t infoCount = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &infoCount) == KERN_SUCCESS)
+        rec.rssBytes = info.resident_size;
+#elif defined(__linux__)
+    // statm: size resident shared text lib data dt - in pages.
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f) {
+        unsigned long size, resident;
+        if (fscanf(f, "%lu %lu", &size, &resident) == 2)
+            rec.rssBytes = (uint64_t)resident * sysconf(_SC_PAGESIZE);
+        fclose(f);
+    }
+#endif
+#endif
+
+    // LVGL's heap only exists after lv_init() - samples taken before (e.g. "SETUP-pre-lvgl") leave
+    // the lv* fields 0.
+    if (lv_is_initialized()) {
+        lv_mem_monitor_t mon;
+        lv_mem_monitor(&mon);
+        rec.lvFree = mon.free_size;
+        rec.lvBiggestFree = mon.free_biggest_size;
+        rec.lvFragPct = mon.frag_pct;
+        rec.lvUsedPct = mon.used_pct;
+    }
 
     strncpy(rec.sampleName, sampName, MAX_SAMPLENAME);
     rec.sampleName[MAX_SAMPLENAME] = 0;     // Guarantee null termination beyond MAX_SAMPLENAME by one character
 
-    samples.push_back(rec);
-#endif
+    // Rings - the oldest sample is overwritten once full. Automatic samples have their own ring
+    // so a long run doesn't push out the samples taken at startup.
+    if (bAuto) {
+        autoSamples[nextAuto] = rec;
+        nextAuto = (nextAuto + 1) % LVPP_SYSTATS_AUTO_SAMPLES;
+        if (autoCount < LVPP_SYSTATS_AUTO_SAMPLES)
+            autoCount++;
+    }
+    else {
+        samples[nextSample] = rec;
+        nextSample = (nextSample + 1) % LVPP_SYSTATS_SAMPLES;
+        if (sampleCount < LVPP_SYSTATS_SAMPLES)
+            sampleCount++;
+    }
+    bLatestAuto = bAuto;
+
+    aggregate(rec);
 }
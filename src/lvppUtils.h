@@ -32,6 +32,7 @@
 #endif
 
 #include <vector>
+#include <stdint.h>
 #include <string>
 #include <sstream>
 #include <iomanip>
@@ -43,19 +44,70 @@
 
 constexpr uint16_t MAX_SAMPLENAME = 32;
 
+/**
+ * @brief Number of takeSample() samples espSystats keeps - the oldest are overwritten beyond this.
+ *        Can be overridden in platform.ini...build_flags with -D LVPP_SYSTATS_SAMPLES=n
+ */
+#ifndef LVPP_SYSTATS_SAMPLES
+#define LVPP_SYSTATS_SAMPLES 50
+#endif
+
+/**
+ * @brief Number of startAutoSample() samples espSystats keeps, in a ring of their own.
+ *        Can be overridden in platform.ini...build_flags with -D LVPP_SYSTATS_AUTO_SAMPLES=n
+ */
+#ifndef LVPP_SYSTATS_AUTO_SAMPLES
+#define LVPP_SYSTATS_AUTO_SAMPLES 16
+#endif
+
+/**
+ * @brief Number of distinct sample names espSystats keeps min/max/mean aggregates for.
+ *        Can be overridden in platform.ini...build_flags with -D LVPP_SYSTATS_NAMES=n
+ */
+#ifndef LVPP_SYSTATS_NAMES
+#define LVPP_SYSTATS_NAMES 16
+#endif
+
+static_assert(LVPP_SYSTATS_NAMES <= UINT16_MAX, "LVPP_SYSTATS_NAMES must fit espSystats::aggCount");
+
+struct _lv_timer_t;
+
 /**
  * @brief Struct which holds the data taken in each sample for espSystats class.
  *        A typedef of espRec_t is created for ease of use as well.
  * 
+ * On the host (simulator) build the heap fields come from mallinfo2() (glibc) or mstats() (macOS):
+ * heapSize is the memory malloc holds from the OS, heapFree the free part of it and
+ * heapLowWaterMark the lowest heapFree seen so far. malloc has no notion of a largest free block,
+ * so heapLargestBlock is 0 there. Hosts with neither leave the heap fields 0 - getStaticStats()
+ * says which sources were used.
  */
 typedef struct espRec {
     uint32_t heapFree;
     uint32_t heapSize;
     uint32_t heapLargestBlock;
     uint32_t heapLowWaterMark;
+    uint32_t lvFree;            ///< LVGL's internal heap (lv_mem_monitor()) - free bytes. 0 with LV_MEM_CUSTOM or before lv_init().
+    uint32_t lvBiggestFree;     ///< LVGL's internal heap - biggest free block.
+    uint8_t lvFragPct;          ///< LVGL's internal heap - fragmentation percent.
+    uint8_t lvUsedPct;          ///< LVGL's internal heap - used percent.
+    uint64_t rssBytes;          ///< Host only: resident set size (/proc/self/statm or task_info()). 0 on ESP32 or when unavailable.
     char sampleName[MAX_SAMPLENAME+1];
 } espRec_t;
 
+/**
+ * @brief Running aggregates of all samples taken under one name - kept for every sample ever
+ *        taken, not only those still held in the ring.
+ */
+typedef struct espAgg {
+    char sampleName[MAX_SAMPLENAME+1];
+    uint32_t count;
+    uint32_t heapFreeMin, heapFreeMax;
+    uint64_t heapFreeSum;       ///< Mean is heapFreeSum / count.
+    uint32_t lvFreeMin, lvFreeMax;
+    uint64_t lvFreeSum;
+} espAgg_t;
+
 /**
  * @brief Data gather and report on ESP32 system stats - mostly memory heap.
  * 
@@ -71,26 +123,37 @@ typedef struct espRec {
  * An example of the output from printFullReport() follows:
  * 
  *     ESP32 STATS: CPU Speed(MHz): 160, Sketch Size: 874400, Sketch Free Space: 436320
- *     ----------------------------------------------------------------------------
- *     | HEAPSIZ | FREE    | LARGEST | MIN     | SAMPLE NAME                      |
- *     ----------------------------------------------------------------------------
- *     | 312060  | 286928  | 110580  | 281356  | SETUP-pre-tft                    |
- *     | 311996  | 286628  | 110580  | 281056  | SETUP-pre-lvgl                   |
- *     | 310940  | 282516  | 110580  | 276908  | SETUP-post-lvgl                  |
- *     | 310940  | 282412  | 110580  | 276684  | SETUP-pre-widgets                |
- *     | 310068  | 191452  | 69620   | 185880  | Splash-start                     |
- *     | 306908  | 173676  | 64500   | 173580  | SETUP-end                        |
- *     | 306892  | 173708  | 64500   | 171492  | Splash-end                       |
- *     ----------------------------------------------------------------------------
+ *     ----------------------------------------------------------------------------------------------------------
+ *     | HEAPSIZ | FREE    | LARGEST | MIN     | LV_FREE | LV_BIG  | FRAG    | SAMPLE NAME                      |
+ *     ----------------------------------------------------------------------------------------------------------
+ *     | 312060  | 286928  | 110580  | 281356  | 0       | 0       | 0       | SETUP-pre-tft                    |
+ *     | 311996  | 286628  | 110580  | 281056  | 0       | 0       | 0       | SETUP-pre-lvgl                   |
+ *     | 310940  | 282516  | 110580  | 276908  | 29804   | 29120   | 2       | SETUP-post-lvgl                  |
+ *     | 310940  | 282412  | 110580  | 276684  | 29804   | 29120   | 2       | SETUP-pre-widgets                |
+ *     | 310068  | 191452  | 69620   | 185880  | 18236   | 15872   | 12      | Splash-start                     |
+ *     | 306908  | 173676  | 64500   | 173580  | 16920   | 14336   | 15      | SETUP-end                        |
+ *     | 306892  | 173708  | 64500   | 171492  | 16988   | 14336   | 15      | Splash-end                       |
+ *     | AUTO SAMPLES -------------------------------------------------------------------------------------------
+ *     | 306892  | 172944  | 64500   | 170220  | 16804   | 14336   | 16      | auto                             |
+ *     | 306892  | 172980  | 64500   | 170220  | 16816   | 14336   | 16      | auto                             |
+ *     ----------------------------------------------------------------------------------------------------------
+ * 
+ * Every sample also records LVGL's internal heap (free, biggest free block, fragmentation),
+ * shown as the LV_FREE, LV_BIG and FRAG columns - 0 for samples taken before lv_init(). Samples from startAutoSample() are kept in a
+ * ring of their own and listed after the others, so periodic sampling never pushes out the
+ * samples taken during startup.
  * 
- * _Note: Class is functional on ESP32, but on a simulated environment simply prints
- *        (via printf()) a note that such stats are unavailable._
+ * _Note: On a simulated (host) environment the heap figures come from mallinfo2() or mstats()
+ *        and the RSS (an added column) from /proc/self/statm or task_info(), so memory regressions
+ *        can be tracked in the simulator and in CI as well. The static stats line names the
+ *        sources, or says "unavailable" where the host has none._
  */
 
 
 class espSystats {
 public:
     espSystats();
+    ~espSystats() { stopAutoSample(); };    ///< The auto sample timer points back at us.
 /**
  * @brief Take a data sample immediately and memorialize it with the name passed in the argument.
  * 
@@ -138,24 +201,28 @@ public:
  * at a point when startup is relatively stable, this function is called to get a single final
  * report to view.
  * 
- * This function can be called multiple times, however there is no facility to clear out prior
- * records. Any newly taken samples will be appended to the report in subsequent calls for
- * a full report.
+ * This function can be called multiple times; samples taken since show up in later reports.
+ * Only the latest LVPP_SYSTATS_SAMPLES takeSample() samples and LVPP_SYSTATS_AUTO_SAMPLES
+ * automatic samples are held, the oldest of each overwritten first. getAggregateReport()
+ * covers every sample taken.
  * 
  * A sample output report follows:
  * 
  *     ESP32 STATS: CPU Speed(MHz): 160, Sketch Size: 874400, Sketch Free Space: 436320
- *     ----------------------------------------------------------------------------
- *     | HEAPSIZ | FREE    | LARGEST | MIN     | SAMPLE NAME                      |
- *     ----------------------------------------------------------------------------
- *     | 312060  | 286928  | 110580  | 281356  | SETUP-pre-tft                    |
- *     | 311996  | 286628  | 110580  | 281056  | SETUP-pre-lvgl                   |
- *     | 310940  | 282516  | 110580  | 276908  | SETUP-post-lvgl                  |
- *     | 310940  | 282412  | 110580  | 276684  | SETUP-pre-widgets                |
- *     | 310068  | 191452  | 69620   | 185880  | Splash-start                     |
- *     | 306908  | 173676  | 64500   | 173580  | SETUP-end                        |
- *     | 306892  | 173708  | 64500   | 171492  | Splash-end                       |
- *     ----------------------------------------------------------------------------
+ *     ----------------------------------------------------------------------------------------------------------
+ *     | HEAPSIZ | FREE    | LARGEST | MIN     | LV_FREE | LV_BIG  | FRAG    | SAMPLE NAME                      |
+ *     ----------------------------------------------------------------------------------------------------------
+ *     | 312060  | 286928  | 110580  | 281356  | 0       | 0       | 0       | SETUP-pre-tft                    |
+ *     | 311996  | 286628  | 110580  | 281056  | 0       | 0       | 0       | SETUP-pre-lvgl                   |
+ *     | 310940  | 282516  | 110580  | 276908  | 29804   | 29120   | 2       | SETUP-post-lvgl                  |
+ *     | 310940  | 282412  | 110580  | 276684  | 29804   | 29120   | 2       | SETUP-pre-widgets                |
+ *     | 310068  | 191452  | 69620   | 185880  | 18236   | 15872   | 12      | Splash-start                     |
+ *     | 306908  | 173676  | 64500   | 173580  | 16920   | 14336   | 15      | SETUP-end                        |
+ *     | 306892  | 173708  | 64500   | 171492  | 16988   | 14336   | 15      | Splash-end                       |
+ *     | AUTO SAMPLES -------------------------------------------------------------------------------------------
+ *     | 306892  | 172944  | 64500   | 170220  | 16804   | 14336   | 16      | auto                             |
+ *     | 306892  | 172980  | 64500   | 170220  | 16816   | 14336   | 16      | auto                             |
+ *     ----------------------------------------------------------------------------------------------------------
  * 
  */
     void printFullReport();
@@ -166,18 +233,85 @@ public:
  * @return std::string Full report returned as a std::string object.
  */
     std::string getFullReport();
+/**
+ * @brief Get the most recent sample, e.g. to check a memory budget in a CI run.
+ * 
+ * @param rec Filled in with the sample.
+ * @return false if no sample has been taken.
+ */
+    bool getLatestSample(espRec_t& rec);
+/**
+ * @brief Number of samples held - at most LVPP_SYSTATS_SAMPLES plus LVPP_SYSTATS_AUTO_SAMPLES.
+ */
+    uint32_t getSampleCount() { return sampleCount + autoCount; };
+/**
+ * @brief Get the aggregates of one sample name.
+ * 
+ * @return false if no sample of that name was taken (or the name table was full).
+ */
+    bool getAggregate(const char* sampName, espAgg_t& agg);
+/**
+ * @brief Print a table of min/max/mean free heap (and LVGL heap) per sample name.
+ */
+    void printAggregateReport();
+    std::string getAggregateReport();
+/**
+ * @brief Take a sample every periodMs from an LVGL timer - for long-running units. These go to
+ *        their own ring of LVPP_SYSTATS_AUTO_SAMPLES.
+ * 
+ * @param periodMs Sample period.
+ * @param sampName Name given to each automatic sample.
+ */
+    void startAutoSample(uint32_t periodMs, const char* sampName="auto");
+    void stopAutoSample();
+/**
+ * @brief Stream the held samples as CSV text without building the report in RAM - the
+ *        takeSample() ones oldest first, then the automatic ones. The sample name is quoted.
+ * 
+ * @param writeFn Called with one line at a time.
+ * @param pCtx Passed through to writeFn.
+ */
+    void writeCSV(void (*writeFn)(const char* pText, void* pCtx), void* pCtx);
+/**
+ * @brief Print the held samples as CSV via Serial (device) or printf() (host).
+ */
+    void printCSV();
+/**
+ * @brief Stream the held samples in binary: "ESPS", u16 version (2), u16 sizeof(espRec_t),
+ *        u32 count, then count espRec_t records in the order of writeCSV(), in the device's own byte order.
+ * 
+ * @param writeFn Called with each piece of the output.
+ * @param pCtx Passed through to writeFn.
+ */
+    void writeBinary(void (*writeFn)(const void* pData, size_t len, void* pCtx), void* pCtx);
 protected:
+    static void autoSampleCb(struct _lv_timer_t* pTimer);
+    const espRec_t& sampleAt(uint32_t index);   ///< 0 is the oldest takeSample() sample held, automatic samples follow.
+    void aggregate(const espRec_t& rec);
+
 /**
  * @brief Internal worker-bee which actually takes the sample and places it in a record.
  * 
  * @param sampName A simple name to mark in descriptive terms when the sample was taken
  *                 in the lifecycle of the program calling it.
+ * @param bAuto Taken by startAutoSample()'s timer - goes to the automatic ring.
  */
-    void recordSample(const char* sampName); 
+    void recordSample(const char* sampName, bool bAuto=false);
     uint32_t cpuFreqMHz;            ///< The processor frequency at the time of instantiation.
     uint32_t sketchFreeSpace;       ///< Number of bytes remaining in the sketch/program area.
     uint32_t sketchSize;            ///< Number of bytes taken by the current sketch/program.
-    std::vector<espRec_t> samples;  ///< std::vector which stores each sample in the order taken.
+    espRec_t samples[LVPP_SYSTATS_SAMPLES];  ///< Ring of the latest takeSample() samples.
+    uint32_t nextSample = 0;        ///< Ring slot written next.
+    uint32_t sampleCount = 0;       ///< Samples held.
+    espRec_t autoSamples[LVPP_SYSTATS_AUTO_SAMPLES];    ///< Ring of the latest automatic samples.
+    uint32_t nextAuto = 0;          ///< Automatic ring slot written next.
+    uint32_t autoCount = 0;         ///< Automatic samples held.
+    bool bLatestAuto = false;       ///< The newest sample is an automatic one.
+    uint32_t lowestHeapFree = UINT32_MAX;   ///< Host low water mark across all samples.
+    espAgg_t aggs[LVPP_SYSTATS_NAMES];      ///< Per name aggregates, the first aggCount used.
+    uint16_t aggCount = 0;
+    struct _lv_timer_t* pAutoTimer = nullptr;
+    char autoName[MAX_SAMPLENAME+1];
 };
 
 /**
@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+#
+# Convert a JSON screen description into the binary layout format read by lvppLayout::load().
+# See src/lvppLayout.h for the binary format itself.
+#
+# Usage:
+#   lvpp_layout.py settings.json settings.bin
+#   lvpp_layout.py settings.json settings_layout.h --c-array settings_layout
+#
+# JSON description:
+#   {
+#     "widgets": [
+#       { "type": "slider", "name": "Volume", "text": "Vol",
+#         "x": 10, "y": 40, "w": 200, "h": 12, "align": "TOP_LEFT",
+#         "fontSize": 14, "textColor": "#ffffff", "bgColor": "#202020",
+#         "range": [0, 100], "value": 50,
+#         "valueLabel": { "align": "OUT_RIGHT_MID", "x": 10, "y": 0 },
+#         "valueFormat": "%d%%", "decimals": 0,
+#         "adjText": { "text": "Volume", "x": -10, "y": 0 },
+#         "bind": { "observable": 0, "twoWay": true } },
+#       { "type": "dropdown", "name": "Mode", "options": ["Auto", "Heat", "Cool"], "value": 0 }
+#     ]
+#   }
+# Types: button, label, textarea, bar, slider, arc, switch, dropdown, roller.
+# Everything other than "type" and "name" is optional. "bind" indexes the observable array
+# given to lvppLayout::load().
+#
+
+import argparse
+import json
+import struct
+import sys
+
+VERSION = 1
+HEADER_SIZE = 16
+NO_STRING = 0xFFFF
+
+TYPES = {
+    "button": 1, "label": 2, "textarea": 3, "bar": 4, "slider": 5,
+    "arc": 6, "switch": 7, "dropdown": 8, "roller": 9,
+}
+
+PROP_FONT_SIZE = 1
+PROP_TEXT_COLOR = 2
+PROP_BG_COLOR = 3
+PROP_RANGE = 4
+PROP_VALUE = 5
+PROP_OPTIONS = 6
+PROP_VALUE_LABEL = 7
+PROP_VALUE_FORMAT = 8
+PROP_ADJ_TEXT = 9
+PROP_BIND = 10
+
+# lv_align_t in LVGL 8.x
+ALIGN = {
+    "DEFAULT": 0, "TOP_LEFT": 1, "TOP_MID": 2, "TOP_RIGHT": 3,
+    "BOTTOM_LEFT": 4, "BOTTOM_MID": 5, "BOTTOM_RIGHT": 6,
+    "LEFT_MID": 7, "RIGHT_MID": 8, "CENTER": 9,
+    "OUT_TOP_LEFT": 10, "OUT_TOP_MID": 11, "OUT_TOP_RIGHT": 12,
+    "OUT_BOTTOM_LEFT": 13, "OUT_BOTTOM_MID": 14, "OUT_BOTTOM_RIGHT": 15,
+    "OUT_LEFT_TOP": 16, "OUT_LEFT_MID": 17, "OUT_LEFT_BOTTOM": 18,
+    "OUT_RIGHT_TOP": 19, "OUT_RIGHT_MID": 20, "OUT_RIGHT_BOTTOM": 21,
+}
+
+
+class Strings:
+    """String table with de-duplication."""
+
+    def __init__(self):
+        self.data = bytearray()
+        self.offsets = {}
+
+    def add(self, s):
+        if s is None:
+            return NO_STRING
+        if s not in self.offsets:
+            if len(self.data) >= NO_STRING:
+                raise ValueError("string table is full")
+            self.offsets[s] = len(self.data)
+            self.data += s.encode("utf-8") + b"\0"
+        return self.offsets[s]
+
+
+def align(name, where):
+    try:
+        return ALIGN[name.upper()]
+    except KeyError:
+        raise ValueError("%s: unknown alignment '%s'" % (where, name))
+
+
+def color(value, where):
+    if isinstance(value, int):
+        return value
+    if isinstance(value, str) and value.startswith("#") and len(value) == 7:
+        return int(value[1:], 16)
+    raise ValueError("%s: colors are \"#rrggbb\" or an integer" % where)
+
+
+def prop(tag, payload):
+    return struct.pack("<BB", tag, len(payload)) + payload
+
+
+def widget_record(w, strings):
+    where = w.get("name", "<unnamed>")
+    if "name" not in w or "type" not in w:
+        raise ValueError("%s: every widget needs a type and a name" % where)
+    if w["type"] not in TYPES:
+        raise ValueError("%s: unknown type '%s'" % (where, w["type"]))
+
+    props = bytearray()
+    if "fontSize" in w:
+        props += prop(PROP_FONT_SIZE, struct.pack("<B", w["fontSize"]))
+    if "textColor" in w:
+        props += prop(PROP_TEXT_COLOR, struct.pack("<I", color(w["textColor"], where)))
+    if "bgColor" in w:
+        props += prop(PROP_BG_COLOR, struct.pack("<I", color(w["bgColor"], where)))
+    # Options and range before value so the value lands inside them.
+    if "options" in w:
+        opts = w["options"]
+        if isinstance(opts, list):
+            opts = "\n".join(opts)
+        props += prop(PROP_OPTIONS, struct.pack("<H", strings.add(opts)))
+    if "range" in w:
+        props += prop(PROP_RANGE, struct.pack("<hh", w["range"][0], w["range"][1]))
+    if "valueLabel" in w:
+        vl = w["valueLabel"]
+        props += prop(PROP_VALUE_LABEL, struct.pack("<Bhh", align(vl.get("align", "CENTER"), where),
+                                                    vl.get("x", 0), vl.get("y", 0)))
+    if "valueFormat" in w:
+        props += prop(PROP_VALUE_FORMAT, struct.pack("<HB", strings.add(w["valueFormat"]), w.get("decimals", 0)))
+    if "value" in w:
+        props += prop(PROP_VALUE, struct.pack("<h", w["value"]))
+    if "adjText" in w:
+        at = w["adjText"]
+        props += prop(PROP_ADJ_TEXT, struct.pack("<Hhh", strings.add(at["text"]),
+                                                 at.get("x", -10000), at.get("y", -10000)))
+    if "bind" in w:
+        b = w["bind"]
+        props += prop(PROP_BIND, struct.pack("<BB", b["observable"], 1 if b.get("twoWay") else 0))
+
+    rec = struct.pack("<BBHHHhhhh", TYPES[w["type"]], align(w.get("align", "DEFAULT"), where), 0,
+                      strings.add(w["name"]), strings.add(w.get("text")),
+                      w.get("x", 0), w.get("y", 0), w.get("w", 0), w.get("h", 0))
+    rec = bytearray(rec) + props
+    if len(rec) > 0xFFFF:
+        raise ValueError("%s: record too large" % where)
+    struct.pack_into("<H", rec, 2, len(rec))
+    return rec
+
+
+def convert(desc):
+    strings = Strings()
+    records = bytearray()
+    widgets = desc.get("widgets", [])
+
+    for w in widgets:
+        records += widget_record(w, strings)
+
+    if not strings.data:
+        strings.add("")
+
+    header = b"LVPL" + struct.pack("<BBHII", VERSION, 0, len(widgets), HEADER_SIZE, HEADER_SIZE + len(records))
+    return header + records + strings.data
+
+
+def c_array(blob, name):
+    lines = ["// Generated by lvpp_layout.py - do not edit.", "#include <stdint.h>", "",
+             "const uint8_t %s[%d] = {" % (name, len(blob))]
+    for i in range(0, len(blob), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in blob[i:i+16]) + ",")
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Convert a JSON screen description to an lvpp binary layout.")
+    ap.add_argument("input", help="JSON description")
+    ap.add_argument("output", help="Output file (binary, or C source with --c-array)")
+    ap.add_argument("--c-array", metavar="NAME", help="Write a C array named NAME instead of raw binary")
+    args = ap.parse_args()
+
+    with open(args.input) as f:
+        desc = json.load(f)
+
+    try:
+        blob = convert(desc)
+    except (ValueError, KeyError, IndexError, struct.error) as e:
+        sys.exit("lvpp_layout: %s" % e)
+
+    if args.c_array:
+        with open(args.output, "w") as f:
+            f.write(c_array(blob, args.c_array))
+    else:
+        with open(args.output, "wb") as f:
+            f.write(blob)
+
+    print("%s: %d widgets, %d bytes" % (args.output, len(desc.get("widgets", [])), len(blob)))
+
+
+if __name__ == "__main__":
+    main()